@@ -0,0 +1,182 @@
+#include "CarveJobScheduler.h"
+#include <algorithm>
+#include <spdlog/spdlog.h>
+
+SeamCarver::ProgressCallback CarveJobContext::progress() const {
+    CancellationToken cancelled = token;
+    CarveJobStatus* jobStatus = &status;
+    return [cancelled, jobStatus](unsigned int done, unsigned int total) {
+        jobStatus->progressPercent.store(total != 0 ? static_cast<unsigned int>(static_cast<uint64_t>(done) * 100 / total) : 100u,
+                                         std::memory_order_relaxed);
+        return !cancelled.isCancelled();
+    };
+}
+
+SeamCarver::ProgressCallback progressSlice(const SeamCarver::ProgressCallback& progress, unsigned int part, unsigned int parts) {
+    if (!progress) return nullptr;
+    return [progress, part, parts](unsigned int done, unsigned int total) {
+        if (total == 0) return progress(part + 1, parts);
+        return progress(part * total + done, parts * total);
+    };
+}
+
+// Heap order: std::push_heap keeps the "largest" on top, i.e. the highest priority and,
+// among equal priorities, the lowest (oldest) id
+static bool runsLater(int priorityA, uint64_t idA, int priorityB, uint64_t idB) {
+    return priorityA != priorityB ? priorityA < priorityB : idA > idB;
+}
+
+CarveJobScheduler::CarveJobScheduler(unsigned int threadCount) {
+    if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned int i = 0; i < threadCount; ++i) {
+        workers.emplace_back(&CarveJobScheduler::workerLoop, this);
+    }
+}
+
+CarveJobScheduler::~CarveJobScheduler() {
+    {
+        std::lock_guard<std::mutex> lk(mtx);
+        stopping = true;
+        cancelLocked([](uint64_t, uint64_t) { return true; });
+    }
+    cv.notify_all();
+    for (auto& worker : workers) worker.join();
+}
+
+void CarveJobScheduler::workerLoop() {
+    while (true) {
+        Entry entry;
+        {
+            std::unique_lock<std::mutex> lk(mtx);
+            cv.wait(lk, [&]() { return stopping || !queue.empty(); });
+            if (queue.empty()) return; // stopping, queued jobs were cancelled
+            std::pop_heap(queue.begin(), queue.end(), [](const Entry& a, const Entry& b) {
+                return runsLater(a.priority, a.id, b.priority, b.id);
+            });
+            entry = std::move(queue.back());
+            queue.pop_back();
+            running.push_back({entry.id, entry.group, entry.token});
+        }
+
+        entry.status->state.store(CarveJobState::Running);
+        ImageData result;
+        std::exception_ptr failure;
+        try {
+            result = entry.task(CarveJobContext{entry.token, *entry.status});
+        } catch (...) {
+            failure = std::current_exception(); // e.g. std::bad_alloc, rethrown by the future
+        }
+
+        {
+            std::lock_guard<std::mutex> lk(mtx);
+            running.erase(std::find_if(running.begin(), running.end(), [&](const Running& r) { return r.id == entry.id; }));
+        }
+        if (failure) {
+            entry.status->state.store(CarveJobState::Failed);
+            entry.promise.set_exception(failure);
+            continue;
+        }
+        // A job cancelled while running may have finished anyway: its result is dropped
+        const bool cancelled = entry.token.isCancelled();
+        entry.status->state.store(cancelled ? CarveJobState::Cancelled : CarveJobState::Done);
+        entry.promise.set_value(cancelled ? ImageData() : std::move(result));
+    }
+}
+
+template <typename Match>
+unsigned int CarveJobScheduler::cancelLocked(const Match& match) {
+    unsigned int count = 0;
+    auto queuedEnd = std::partition(queue.begin(), queue.end(), [&](const Entry& e) { return !match(e.id, e.group); });
+    for (auto it = queuedEnd; it != queue.end(); ++it) {
+        it->token.cancel();
+        it->status->state.store(CarveJobState::Cancelled);
+        it->promise.set_value(ImageData());
+        ++count;
+    }
+    if (queuedEnd != queue.end()) {
+        queue.erase(queuedEnd, queue.end());
+        std::make_heap(queue.begin(), queue.end(), [](const Entry& a, const Entry& b) {
+            return runsLater(a.priority, a.id, b.priority, b.id);
+        });
+    }
+    for (const Running& r : running) {
+        if (match(r.id, r.group) && !r.token.isCancelled()) {
+            r.token.cancel();
+            ++count;
+        }
+    }
+    return count;
+}
+
+CarveJobHandle CarveJobScheduler::submit(Task task, int priority, uint64_t group) {
+    CarveJobHandle handle;
+    handle.status = std::make_shared<CarveJobStatus>();
+    Entry entry{priority, 0, group, std::move(task), handle.token, handle.status, {}};
+    handle.result = entry.promise.get_future();
+    {
+        std::lock_guard<std::mutex> lk(mtx);
+        if (group != 0) cancelLocked([group](uint64_t, uint64_t g) { return g == group; });
+        entry.id = handle.id = nextId++;
+        if (stopping) {
+            handle.status->state.store(CarveJobState::Cancelled);
+            entry.promise.set_value(ImageData());
+            return handle;
+        }
+        queue.push_back(std::move(entry));
+        std::push_heap(queue.begin(), queue.end(), [](const Entry& a, const Entry& b) {
+            return runsLater(a.priority, a.id, b.priority, b.id);
+        });
+    }
+    cv.notify_one();
+    return handle;
+}
+
+CarveJobHandle CarveJobScheduler::submit(CarveJob job, int priority, uint64_t group) {
+    return submit([job = std::move(job)](const CarveJobContext& context) { return run(job, context); }, priority, group);
+}
+
+unsigned int CarveJobScheduler::cancel(uint64_t id) {
+    std::lock_guard<std::mutex> lk(mtx);
+    return cancelLocked([id](uint64_t i, uint64_t) { return i == id; });
+}
+
+unsigned int CarveJobScheduler::cancelGroup(uint64_t group) {
+    std::lock_guard<std::mutex> lk(mtx);
+    return cancelLocked([group](uint64_t, uint64_t g) { return g == group; });
+}
+
+unsigned int CarveJobScheduler::cancelAll() {
+    std::lock_guard<std::mutex> lk(mtx);
+    return cancelLocked([](uint64_t, uint64_t) { return true; });
+}
+
+size_t CarveJobScheduler::getQueuedCount() {
+    std::lock_guard<std::mutex> lk(mtx);
+    return queue.size();
+}
+
+ImageData CarveJobScheduler::run(const CarveJob& job, const CarveJobContext& context) {
+    const unsigned int width = job.source.getWidth();
+    const unsigned int height = job.source.getHeight();
+    const unsigned int targetHeight = job.targetHeight ? job.targetHeight : height;
+    if (job.targetWidth == 0 || job.targetWidth > 2 * width || targetHeight > height) {
+        spdlog::error("CarveJobScheduler: invalid target size {}x{} for an image of {}x{}.", job.targetWidth, targetHeight, width, height);
+        return ImageData();
+    }
+
+    const SeamCarver::ProgressCallback progress = context.progress();
+    ImageData carved;
+    if (job.targetWidth > width) {
+        // Two passes: each reports half of the range
+        const unsigned int passes = targetHeight < height ? 2 : 1;
+        carved = SeamCarver::insertSeams(job.source, job.targetWidth, job.options, progressSlice(progress, 0, passes));
+        if (carved.getWidth() != 0 && targetHeight < height) {
+            carved = SeamCarver::carveHeight(carved, targetHeight, job.options, progressSlice(progress, 1, passes));
+        }
+    } else {
+        carved = SeamCarver::retarget(job.source, job.targetWidth, targetHeight, job.options, job.order, progress);
+    }
+    if (context.token.isCancelled()) return ImageData();
+    context.status.progressPercent.store(100, std::memory_order_relaxed);
+    return carved;
+}
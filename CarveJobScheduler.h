@@ -0,0 +1,143 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "ImageData.h"
+#include "SeamCarver.h"
+
+// Cooperative cancellation flag. Copies share the flag, so the scheduler, the handle and
+// the running job all see the same state; jobs poll it (usually from their progress callback).
+class CancellationToken {
+private:
+    std::shared_ptr<std::atomic<bool>> flag = std::make_shared<std::atomic<bool>>(false);
+
+public:
+    void cancel() const { flag->store(true, std::memory_order_relaxed); }
+    bool isCancelled() const { return flag->load(std::memory_order_relaxed); }
+};
+
+enum class CarveJobState { Queued, Running, Done, Cancelled, Failed };
+
+// Live state of one job, shared by the scheduler, the job and its handle
+struct CarveJobStatus {
+    std::atomic<CarveJobState> state{CarveJobState::Queued};
+    std::atomic<unsigned int> progressPercent{0};
+};
+
+// Retarget 'source' to targetWidth x targetHeight: the width may shrink or grow up to 2x
+// (seam insertion), the height may only shrink (0 keeps the source height)
+struct CarveJob {
+    ImageData source;
+    unsigned int targetWidth = 0;
+    unsigned int targetHeight = 0;
+    SeamCarveOptions options;
+    RetargetOrder order = RetargetOrder::WidthFirst;
+};
+
+// Maps 'progress' onto part 'part' of 'parts' equal slices, for jobs that run several
+// carving passes in a row (e.g. widen, then shorten) without restarting at 0%
+SeamCarver::ProgressCallback progressSlice(const SeamCarver::ProgressCallback& progress, unsigned int part, unsigned int parts);
+
+// What a running job gets from the scheduler
+struct CarveJobContext {
+    CancellationToken token;
+    CarveJobStatus& status;
+
+    // SeamCarver progress callback: publishes the percentage, returns false once cancelled
+    SeamCarver::ProgressCallback progress() const;
+};
+
+// Result and control of a submitted job (move only, like the future it holds)
+class CarveJobHandle {
+private:
+    friend class CarveJobScheduler;
+    uint64_t id = 0;
+    CancellationToken token;
+    std::shared_ptr<CarveJobStatus> status;
+    std::future<ImageData> result;
+
+public:
+    bool valid() const { return result.valid(); }
+    uint64_t getId() const { return id; }
+    CarveJobState getState() const { return status ? status->state.load() : CarveJobState::Cancelled; }
+    unsigned int getProgress() const { return status ? status->progressPercent.load(std::memory_order_relaxed) : 0; }
+    bool isPending() const { return getState() == CarveJobState::Queued || getState() == CarveJobState::Running; }
+    // Never blocks: a queued job is dropped, a running one stops at its next progress check
+    void cancel() const { token.cancel(); }
+    // True once get() returns without blocking
+    bool ready() const { return result.valid() && result.wait_for(std::chrono::seconds(0)) == std::future_status::ready; }
+    // Waits for the job. Cancelled jobs yield an empty image, a failed one rethrows.
+    ImageData get() { return result.get(); }
+};
+
+// Priority queue of carve jobs run by a few long-lived threads. The data-parallel stages
+// inside each job still go through ThreadPool::shared(), whose waiting callers help with
+// the chunks of other jobs' loops, so concurrent jobs share the cores without idling.
+class CarveJobScheduler {
+public:
+    using Task = std::function<ImageData(const CarveJobContext&)>;
+
+private:
+    struct Entry {
+        int priority;
+        uint64_t id;
+        uint64_t group;
+        Task task;
+        CancellationToken token;
+        std::shared_ptr<CarveJobStatus> status;
+        std::promise<ImageData> promise;
+    };
+    struct Running {
+        uint64_t id;
+        uint64_t group;
+        CancellationToken token;
+    };
+
+    std::vector<std::thread> workers;
+    std::vector<Entry> queue;     // Heap: highest priority first, then submission order
+    std::vector<Running> running; // Jobs currently on a worker
+    std::mutex mtx;               // protects queue, running, nextId and stopping
+    std::condition_variable cv;
+    uint64_t nextId = 1;
+    bool stopping = false;
+
+    void workerLoop();
+    // Cancels the queued and running jobs matching 'match' (call with mtx held)
+    template <typename Match>
+    unsigned int cancelLocked(const Match& match);
+
+public:
+    // 'threadCount' jobs run at the same time (0 = one per hardware thread)
+    explicit CarveJobScheduler(unsigned int threadCount = 0);
+    // Cancels everything still queued or running and waits for the running jobs
+    ~CarveJobScheduler();
+
+    CarveJobScheduler(const CarveJobScheduler&) = delete;
+    CarveJobScheduler& operator=(const CarveJobScheduler&) = delete;
+
+    // Queues 'task'; higher priorities run first, equal priorities in submission order.
+    // A non-zero 'group' supersedes: the queued and running jobs of that group are
+    // cancelled first, so e.g. a UI only ever computes its latest request.
+    CarveJobHandle submit(Task task, int priority = 0, uint64_t group = 0);
+    CarveJobHandle submit(CarveJob job, int priority = 0, uint64_t group = 0);
+
+    // Returns the number of jobs that were cancelled
+    unsigned int cancel(uint64_t id);
+    unsigned int cancelGroup(uint64_t group);
+    unsigned int cancelAll();
+
+    size_t getQueuedCount();
+    unsigned int getThreadCount() const { return static_cast<unsigned int>(workers.size()); }
+
+    // Runs 'job' on the calling thread (what submit(CarveJob) schedules).
+    // Returns an empty image on invalid targets or cancellation.
+    static ImageData run(const CarveJob& job, const CarveJobContext& context);
+};
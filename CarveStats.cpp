@@ -0,0 +1,114 @@
+#include "CarveStats.h"
+#include <algorithm>
+#include <fmt/format.h>
+
+const char* carveStageName(CarveStage stage) {
+    switch (stage) {
+        case CarveStage::Energy: return "energy";
+        case CarveStage::MinimalPath: return "minimal_path";
+        case CarveStage::Backtrack: return "backtrack";
+        case CarveStage::Removal: return "removal";
+        default: return "unknown";
+    }
+}
+
+void CarveStats::reset() {
+    for (auto& stage : stages) {
+        stage.count.store(0, std::memory_order_relaxed);
+        stage.totalNs.store(0, std::memory_order_relaxed);
+        stage.maxNs.store(0, std::memory_order_relaxed);
+        for (auto& bucket : stage.histogram) bucket.store(0, std::memory_order_relaxed);
+    }
+    seams.store(0, std::memory_order_relaxed);
+    bytesAllocated.store(0, std::memory_order_relaxed);
+    traceHead.store(0, std::memory_order_release);
+    epochNs.store(now(), std::memory_order_relaxed);
+}
+
+void CarveStats::record(CarveStage stage, Clock::time_point start, Clock::time_point end) {
+    const uint64_t durationNs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+    StageCounters& counters = stages[static_cast<size_t>(stage)];
+    counters.count.fetch_add(1, std::memory_order_relaxed);
+    counters.totalNs.fetch_add(durationNs, std::memory_order_relaxed);
+    // Single recording thread, so load + store is enough for the maximum
+    if (durationNs > counters.maxNs.load(std::memory_order_relaxed)) counters.maxNs.store(durationNs, std::memory_order_relaxed);
+
+    unsigned int bucket = 0;
+    for (uint64_t us = durationNs / 1000; us != 0 && bucket + 1 < CarveStatsSnapshot::kHistogramBuckets; us >>= 1) ++bucket;
+    counters.histogram[bucket].fetch_add(1, std::memory_order_relaxed);
+
+    // Fill the slot, then publish it by advancing the head
+    const uint64_t head = traceHead.load(std::memory_order_relaxed);
+    TraceEvent& event = trace[head % kTraceCapacity];
+    const int64_t startNs = std::chrono::duration_cast<std::chrono::nanoseconds>(start.time_since_epoch()).count();
+    event.stage.store(static_cast<uint32_t>(stage), std::memory_order_relaxed);
+    event.startNs.store(static_cast<uint64_t>(std::max<int64_t>(0, startNs - epochNs.load(std::memory_order_relaxed))), std::memory_order_relaxed);
+    event.durationNs.store(durationNs, std::memory_order_relaxed);
+    traceHead.store(head + 1, std::memory_order_release);
+}
+
+CarveStatsSnapshot CarveStats::snapshot() const {
+    CarveStatsSnapshot result;
+    for (size_t i = 0; i < stages.size(); ++i) {
+        const StageCounters& counters = stages[i];
+        CarveStatsSnapshot::Stage& stage = result.stages[i];
+        stage.count = counters.count.load(std::memory_order_relaxed);
+        stage.totalNs = counters.totalNs.load(std::memory_order_relaxed);
+        stage.maxNs = counters.maxNs.load(std::memory_order_relaxed);
+        for (size_t b = 0; b < stage.histogram.size(); ++b) stage.histogram[b] = counters.histogram[b].load(std::memory_order_relaxed);
+    }
+    result.seams = seams.load(std::memory_order_relaxed);
+    result.bytesAllocated = bytesAllocated.load(std::memory_order_relaxed);
+    result.elapsedNs = static_cast<uint64_t>(std::max<int64_t>(0, now() - epochNs.load(std::memory_order_relaxed)));
+    return result;
+}
+
+std::string CarveStats::toJson() const {
+    const CarveStatsSnapshot s = snapshot();
+    std::string json = fmt::format("{{\"elapsed_ms\":{:.3f},\"seams\":{},\"seams_per_second\":{:.1f},\"bytes_allocated\":{},\"stages\":{{",
+                                   s.elapsedNs / 1e6, s.seams, s.seamsPerSecond(), s.bytesAllocated);
+    for (size_t i = 0; i < s.stages.size(); ++i) {
+        const CarveStatsSnapshot::Stage& stage = s.stages[i];
+        json += fmt::format("{}\"{}\":{{\"count\":{},\"total_ms\":{:.3f},\"mean_us\":{:.3f},\"max_us\":{:.3f},\"histogram_us_log2\":[",
+                            i ? "," : "", carveStageName(static_cast<CarveStage>(i)), stage.count, stage.totalNs / 1e6,
+                            stage.count ? stage.totalNs / 1e3 / stage.count : 0.0, stage.maxNs / 1e3);
+        for (size_t b = 0; b < stage.histogram.size(); ++b) json += fmt::format("{}{}", b ? "," : "", stage.histogram[b]);
+        json += "]}";
+    }
+    json += "}}";
+    return json;
+}
+
+std::string CarveStats::toChromeTrace() const {
+    // Events [head - capacity + 1, head) cannot be overwritten while we copy them
+    const uint64_t head = traceHead.load(std::memory_order_acquire);
+    const uint64_t first = head > kTraceCapacity ? head - kTraceCapacity + 1 : 0;
+
+    struct Event {
+        uint64_t index;
+        uint32_t stage;
+        uint64_t startNs;
+        uint64_t durationNs;
+    };
+    std::vector<Event> events;
+    events.reserve(head - first);
+    for (uint64_t i = first; i < head; ++i) {
+        const TraceEvent& e = trace[i % kTraceCapacity];
+        events.push_back({i, e.stage.load(std::memory_order_relaxed), e.startNs.load(std::memory_order_relaxed),
+                          e.durationNs.load(std::memory_order_relaxed)});
+    }
+    // Drop what the recorder overwrote meanwhile
+    const uint64_t headAfter = traceHead.load(std::memory_order_acquire);
+    const uint64_t valid = headAfter > kTraceCapacity ? headAfter - kTraceCapacity + 1 : 0;
+
+    std::string json = "{\"traceEvents\":[";
+    bool firstEvent = true;
+    for (const Event& e : events) {
+        if (e.index < valid || e.stage >= static_cast<uint32_t>(CarveStage::Count)) continue;
+        json += fmt::format("{}{{\"name\":\"{}\",\"cat\":\"carve\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":{:.3f},\"dur\":{:.3f}}}",
+                            firstEvent ? "" : ",", carveStageName(static_cast<CarveStage>(e.stage)), e.startNs / 1e3, e.durationNs / 1e3);
+        firstEvent = false;
+    }
+    json += "],\"displayTimeUnit\":\"ms\"}";
+    return json;
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Stages of one seam carving iteration
+enum class CarveStage { Energy, MinimalPath, Backtrack, Removal, Count };
+
+const char* carveStageName(CarveStage stage);
+
+// Plain copy of CarveStats for display / export
+struct CarveStatsSnapshot {
+    static constexpr unsigned int kHistogramBuckets = 24;
+
+    struct Stage {
+        uint64_t count = 0;
+        uint64_t totalNs = 0;
+        uint64_t maxNs = 0;
+        // Bucket 0: < 1 us, bucket i: [2^(i-1), 2^i) us, last bucket open ended
+        std::array<uint64_t, kHistogramBuckets> histogram{};
+    };
+
+    std::array<Stage, static_cast<size_t>(CarveStage::Count)> stages;
+    uint64_t seams = 0;
+    uint64_t bytesAllocated = 0;
+    uint64_t elapsedNs = 0; // since the last reset
+
+    double seamsPerSecond() const { return elapsedNs ? seams * 1e9 / elapsedNs : 0.0; }
+};
+
+// Lock-free instrumentation of the carving loop. One thread (the carving worker) records,
+// any thread may read at any time: counters are relaxed atomics, so a snapshot taken
+// while recording can be a few events behind but never blocks the recorder.
+// The most recent kTraceCapacity stage events are kept in a ring for Chrome tracing.
+class CarveStats {
+public:
+    static constexpr unsigned int kTraceCapacity = 4096;
+    using Clock = std::chrono::steady_clock;
+
+private:
+    struct StageCounters {
+        std::atomic<uint64_t> count{0};
+        std::atomic<uint64_t> totalNs{0};
+        std::atomic<uint64_t> maxNs{0};
+        std::array<std::atomic<uint64_t>, CarveStatsSnapshot::kHistogramBuckets> histogram{};
+    };
+
+    struct TraceEvent {
+        std::atomic<uint32_t> stage{0};
+        std::atomic<uint64_t> startNs{0};
+        std::atomic<uint64_t> durationNs{0};
+    };
+
+    std::array<StageCounters, static_cast<size_t>(CarveStage::Count)> stages;
+    std::atomic<uint64_t> seams{0};
+    std::atomic<uint64_t> bytesAllocated{0};
+    std::atomic<int64_t> epochNs{0}; // Clock time of the last reset
+    std::array<TraceEvent, kTraceCapacity> trace;
+    std::atomic<uint64_t> traceHead{0}; // Total number of events ever written
+
+    static int64_t now() { return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count(); }
+
+public:
+    CarveStats() { reset(); }
+    CarveStats(const CarveStats&) = delete;
+    CarveStats& operator=(const CarveStats&) = delete;
+
+    // Clears all counters and the trace (call from the recording thread)
+    void reset();
+
+    // Records one stage execution; 'start' is the Clock time it began
+    void record(CarveStage stage, Clock::time_point start, Clock::time_point end);
+    void addSeams(uint64_t count) { seams.fetch_add(count, std::memory_order_relaxed); }
+    void addAllocated(uint64_t bytes) { bytesAllocated.fetch_add(bytes, std::memory_order_relaxed); }
+
+    CarveStatsSnapshot snapshot() const;
+
+    // {"elapsed_ms":..., "seams":..., "seams_per_second":..., "bytes_allocated":..., "stages":{...}}
+    std::string toJson() const;
+    // Chrome trace event format (chrome://tracing, Perfetto) of the recent stage events
+    std::string toChromeTrace() const;
+};
+
+// Times a scope as one CarveStage (no-op when 'stats' is null)
+class ScopedStageTimer {
+private:
+    CarveStats* stats;
+    CarveStage stage;
+    CarveStats::Clock::time_point start;
+
+public:
+    ScopedStageTimer(CarveStats* carveStats, CarveStage carveStage)
+        : stats(carveStats), stage(carveStage) {
+        if (stats) start = CarveStats::Clock::now();
+    }
+    ~ScopedStageTimer() {
+        if (stats) stats->record(stage, start, CarveStats::Clock::now());
+    }
+    ScopedStageTimer(const ScopedStageTimer&) = delete;
+    ScopedStageTimer& operator=(const ScopedStageTimer&) = delete;
+};
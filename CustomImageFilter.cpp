@@ -1,58 +1,171 @@
 #include "CustomImageFilter.h"
+#include "CustomImageFilterSimd.h"
+#include "ThreadPool.h"
 #include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
 #include <spdlog/spdlog.h>
 
 
 // Sobel Gx (detects vertical edges)
-std::vector<int> sobelGx = {
+static constexpr int sobelGx[9] = {
     -1, 0, 1,
     -2, 0, 2,
     -1, 0, 1
 };
 
 // Sobel Gy (detects horizontal edges)
-std::vector<int> sobelGy = {
+static constexpr int sobelGy[9] = {
     -1, -2, -1,
      0,  0,  0,
      1,  2,  1
 };
 
 
-ImageData convolution(const ImageData& input, const std::vector<int>& kernel) {
-    ImageData output(input.getWidth(), input.getHeight(), input.getChannels());
+// Mirror an out of bounds coordinate at the image edge (-1 -> 1, n -> n - 2).
+// Degenerate one pixel wide / high images fall back to their only pixel.
+static inline int mirror(int pos, int size) {
+    if (pos < 0) return size > 1 ? -pos : 0;
+    if (pos >= size) return size > 1 ? 2 * (size - 1) - pos : 0;
+    return pos;
+}
+
+// Convolve the 3x3 kernel at pixel (x, y) of a single channel image.
+// Out of bounds taps are mirrored at the image edge. Returns |result| clamped to [0, 255].
+static int convolveAt(const ImageData& input, int x, int y, const int (&kernel)[9]) {
+    int width = static_cast<int>(input.getWidth());
+    int height = static_cast<int>(input.getHeight());
+
+    int convol_res = 0;
+    for (int ky = -1; ky <= 1; ++ky) {
+        for (int kx = -1; kx <= 1; ++kx) {
+            // Boundary check. If out of bounds, mirror edge pixels
+            int posX = mirror(x + kx, width);
+            int posY = mirror(y + ky, height);
+
+            int pixel = input.getRow(posY)[posX];
+
+            // Apply Sobel filter
+            convol_res += pixel * kernel[(ky + 1) * 3 + (kx + 1)];
+        }
+    }
+    // Absolut value
+    convol_res = std::abs(convol_res);
+    // Clamp the result to [0, 255]
+    return std::clamp(convol_res, 0, 255);
+}
 
-    unsigned int height = input.getHeight();
-    unsigned int width = input.getWidth();
+// floor(sqrt(s)) for every s below 255^2; larger sums clamp to 255 anyway.
+// Replaces the per pixel std::sqrt of the L2 magnitude with a 64 KB table.
+static constexpr int kSqrtLutSize = 255 * 255;
+static std::vector<unsigned char> makeSqrtLut() {
+    std::vector<unsigned char> table(kSqrtLutSize);
+    int root = 0;
+    for (int s = 0; s < kSqrtLutSize; ++s) {
+        while ((root + 1) * (root + 1) <= s) ++root;
+        table[s] = static_cast<unsigned char>(root);
+    }
+    return table;
+}
+static const std::vector<unsigned char> sqrtLut = makeSqrtLut();
+
+// Fused Sobel magnitude at column c of a 3-row window (rows y-1, y, y+1 already
+// mirrored). 'l' and 'r' are the mirrored left / right columns.
+static inline unsigned char sobelMagnitude(const unsigned char* up, const unsigned char* mid, const unsigned char* down,
+                                           int l, int c, int r, EnergyNorm norm) {
+    int gx = (up[r] - up[l]) + 2 * (mid[r] - mid[l]) + (down[r] - down[l]);
+    int gy = (down[l] + 2 * down[c] + down[r]) - (up[l] + 2 * up[c] + up[r]);
+    gx = std::min(std::abs(gx), 255);
+    gy = std::min(std::abs(gy), 255);
+
+    if (norm == EnergyNorm::L1) return static_cast<unsigned char>(std::min(gx + gy, 255));
+    int squared = gx * gx + gy * gy;
+    return squared < kSqrtLutSize ? sqrtLut[squared] : 255;
+}
+
+// Fused Sobel magnitude for columns [xBegin, xEnd) of row y: both gradients and the
+// magnitude are computed in one sweep over the sliding 3-row window.
+static void sobelRowScalar(const ImageData& input, ImageData& output, unsigned int y,
+                           unsigned int xBegin, unsigned int xEnd, EnergyNorm norm) {
+    const int width = static_cast<int>(input.getWidth());
+    const int height = static_cast<int>(input.getHeight());
+    const unsigned char* up = input.getRow(mirror(static_cast<int>(y) - 1, height));
+    const unsigned char* mid = input.getRow(y);
+    const unsigned char* down = input.getRow(mirror(static_cast<int>(y) + 1, height));
+    unsigned char* out = output.getRow(y);
+
+    for (int x = static_cast<int>(xBegin); x < static_cast<int>(xEnd); ++x) {
+        out[x] = sobelMagnitude(up, mid, down, mirror(x - 1, width), x, mirror(x + 1, width), norm);
+    }
+}
+
+// Scalar reference convolution over the whole image
+static ImageData convolution(const ImageData& input, const int (&kernel)[9]) {
+    ImageData output(input.getWidth(), input.getHeight(), input.getChannels(), input.getLayout());
 
     for (int y = 0; y < input.getHeight(); ++y) {
+        unsigned char* outRow = output.getRow(y);
         for (int x = 0; x < input.getWidth(); ++x) {
-            // Apply Sobel filter in X direction
-            int convol_res = 0;
-            for (int ky = -1; ky <= 1; ++ky) {
-                for (int kx = -1; kx <= 1; ++kx) {
-                    int posX = x + kx;
-                    int posY = y + ky;
+            outRow[x] = static_cast<unsigned char>(convolveAt(input, x, y, kernel));
+        }
+    }
 
-                    // Boundary check. If out of bounds, mirror edge pixels
-                    if (posX < 0 || posX >= width) posX = x - kx;
-                    if (posY < 0 || posY >= height) posY = y - ky;
+    return output;
+}
 
-                    int pixel = input.pixels[(posY) * width + (posX)];
+static std::atomic<SimdLevel>& activeSimdLevel() {
+    static std::atomic<SimdLevel> level{CustomImageFilter::getSupportedSimdLevel()};
+    return level;
+}
 
-                    // Apply Sobel filter
-                    convol_res += pixel * kernel[(ky + 1) * 3 + (kx + 1)];
-                }
-            }
-            // Absolut value
-            convol_res = std::abs(convol_res);
-            // Clamp the result to [0, 255]
-            convol_res = std::clamp(convol_res, 0, 255);
+SimdLevel CustomImageFilter::getSupportedSimdLevel() {
+    static const SimdLevel supported = simd::detectSimdLevel();
+    return supported;
+}
+
+SimdLevel CustomImageFilter::getSimdLevel() {
+    return activeSimdLevel().load();
+}
 
-            output.pixels[y * width + x] = static_cast<unsigned char>(convol_res);
+void CustomImageFilter::setSimdLevel(SimdLevel level) {
+    activeSimdLevel().store(std::min(level, getSupportedSimdLevel()));
+}
+
+// Vectorized Sobel pass into a preallocated output of the same size. The SIMD kernels
+// cover the interior of each row; the first column and the remainder (mirrored taps)
+// use the scalar code.
+static void sobelSimd(const ImageData& input, ImageData& output, SimdLevel level, simd::SobelOutput what) {
+    const unsigned int width = input.getWidth();
+    const unsigned int height = input.getHeight();
+    const EnergyNorm norm = what == simd::SobelOutput::MagnitudeL1 ? EnergyNorm::L1 : EnergyNorm::L2;
+
+    for (unsigned int y = 0; y < height; ++y) {
+        // Mirror rows at the top and bottom edge
+        const unsigned char* up = input.getRow(y == 0 ? 1 : y - 1);
+        const unsigned char* mid = input.getRow(y);
+        const unsigned char* down = input.getRow(y + 1 == height ? height - 2 : y + 1);
+        unsigned char* out = output.getRow(y);
+
+        const unsigned int xEnd = simd::sobelRow(level, what, up, mid, down, out, width);
+        if (what == simd::SobelOutput::GradX || what == simd::SobelOutput::GradY) {
+            const int (&kernel)[9] = what == simd::SobelOutput::GradX ? sobelGx : sobelGy;
+            out[0] = static_cast<unsigned char>(convolveAt(input, 0, y, kernel));
+            for (unsigned int x = xEnd; x < width; ++x) {
+                out[x] = static_cast<unsigned char>(convolveAt(input, x, y, kernel));
+            }
+        } else {
+            sobelRowScalar(input, output, y, 0, 1, norm);
+            sobelRowScalar(input, output, y, xEnd, width, norm);
         }
     }
+}
 
-    return output;
+// SIMD kernels need at least 3 rows / columns for their mirrored neighbourhood
+static bool useSimd(const ImageData& input, SimdLevel level) {
+    return level != SimdLevel::Scalar && input.getWidth() >= 3 && input.getHeight() >= 3;
 }
 
 ImageData CustomImageFilter::sobelX(const ImageData& input) {
@@ -60,7 +173,12 @@ ImageData CustomImageFilter::sobelX(const ImageData& input) {
         spdlog::error("SobelX filter only supports single channel images.");
         return ImageData();
     }
-    return convolution(input, sobelGx);
+    SimdLevel level = getSimdLevel();
+    if (!useSimd(input, level)) return convolution(input, sobelGx);
+
+    ImageData output(input.getWidth(), input.getHeight(), 1, input.getLayout());
+    sobelSimd(input, output, level, simd::SobelOutput::GradX);
+    return output;
 
 }
 
@@ -69,83 +187,505 @@ ImageData CustomImageFilter::sobelY(const ImageData& input) {
         spdlog::error("SobelY filter only supports single channel images.");
         return ImageData();
     }
-    return convolution(input, sobelGy);
+    SimdLevel level = getSimdLevel();
+    if (!useSimd(input, level)) return convolution(input, sobelGy);
+
+    ImageData output(input.getWidth(), input.getHeight(), 1, input.getLayout());
+    sobelSimd(input, output, level, simd::SobelOutput::GradY);
+    return output;
 
 }
 
 // Convert input image to greyscale
-ImageData CustomImageFilter::toGreyscale(const ImageData& input) {
-    // Ensure output is sized and formatted correctly
-    ImageData output(input.getWidth(), input.getHeight(), 1);
+// Luma of columns [xBegin, xEnd) of one row. Grey + alpha images keep their grey channel.
+template <unsigned int Channels>
+static void lumaRowScalar(const unsigned char* in, unsigned char* out, unsigned int xBegin, unsigned int xEnd) {
+    for (unsigned int x = xBegin; x < xEnd; ++x) {
+        const unsigned char* px = in + x * Channels;
+        if constexpr (Channels < 3) {
+            out[x] = px[0];
+        } else {
+            out[x] = static_cast<unsigned char>((px[0] * simd::kLumaR + px[1] * simd::kLumaG + px[2] * simd::kLumaB +
+                                                 simd::kLumaRound) >> simd::kLumaShift);
+        }
+    }
+}
 
-    auto inIt = input.pixels.begin();
-    auto outIt = output.pixels.begin();
-    while ( (inIt + input.getChannels() - 1) < input.pixels.end() ) {
-        float grey = 0.299f * (*inIt) + 0.587f * (*(inIt + 1)) + 0.114f * (*(inIt + 2));
-        *outIt = static_cast<unsigned char>(grey);
-        inIt += input.getChannels();
-        ++outIt;
+template <unsigned int Channels>
+static void toGreyscaleRows(const ConstImageView& input, ImageData& output, SimdLevel level) {
+    for (unsigned int y = 0; y < input.height; ++y) {
+        const unsigned char* in = input.row(y);
+        unsigned char* out = output.getRow(y);
+        if constexpr (Channels == 1) {
+            std::memcpy(out, in, input.width);
+        } else {
+            const unsigned int xBegin = simd::lumaRow(level, in, Channels, out, input.width);
+            lumaRowScalar<Channels>(in, out, xBegin, input.width);
+        }
     }
+}
 
+static ImageData toGreyscaleView(const ConstImageView& input, RowLayout layout) {
+    ImageData output(input.width, input.height, 1, layout);
+    const SimdLevel level = CustomImageFilter::getSimdLevel();
+    switch (input.channels) {
+        case 1: toGreyscaleRows<1>(input, output, level); break;
+        case 2: toGreyscaleRows<2>(input, output, level); break;
+        case 3: toGreyscaleRows<3>(input, output, level); break;
+        case 4: toGreyscaleRows<4>(input, output, level); break;
+        default:
+            spdlog::error("toGreyscale: unsupported number of channels: {}", input.channels);
+            return ImageData();
+    }
     return output;
 }
 
+ImageData CustomImageFilter::toGreyscale(const ImageData& input) {
+    return toGreyscaleView(input.view(), input.getLayout());
+}
+
+ImageData CustomImageFilter::toGreyscale(const unsigned char* pixels, unsigned int width, unsigned int height,
+                                         unsigned int channels, RowLayout layout) {
+    if (pixels == nullptr) {
+        spdlog::error("toGreyscale: no pixel data.");
+        return ImageData();
+    }
+    return toGreyscaleView({pixels, width, height, channels, width}, layout);
+}
+
 // Combined Sobel filter (magnitude of both directions)
-ImageData CustomImageFilter::sobel(const ImageData& input) {
+ImageData CustomImageFilter::sobel(const ImageData& input, EnergyNorm norm) {
+    ImageData output;
+    sobel(input, output, norm);
+    return output;
+}
+
+// Fused Sobel magnitude: gradients and magnitude are computed in a single sweep, without
+// intermediate gradient images. 'output' is reused if it already has a matching layout.
+void CustomImageFilter::sobel(const ImageData& input, ImageData& output, EnergyNorm norm) {
     if(input.getChannels() != 1) {
         spdlog::error("Sobel filter only supports single channel images.");
-        return ImageData();
+        output = ImageData();
+        return;
     }
 
-    ImageData output(input.getWidth(), input.getHeight(), 1);
+    if (output.getChannels() == 1 && output.getHeight() == input.getHeight() && output.getLayout() == input.getLayout()) {
+        output.setWidth(input.getWidth()); // no reallocation when shrinking
+    } else {
+        output = ImageData(input.getWidth(), input.getHeight(), 1, input.getLayout());
+    }
 
-    ImageData gradX = CustomImageFilter::sobelX(input);
-    ImageData gradY = CustomImageFilter::sobelY(input);
+    SimdLevel level = getSimdLevel();
+    if (useSimd(input, level)) {
+        sobelSimd(input, output, level, norm == EnergyNorm::L1 ? simd::SobelOutput::MagnitudeL1 : simd::SobelOutput::Magnitude);
+        return;
+    }
 
-    for (size_t i = 0; i < output.pixels.size(); ++i) {
-        int magnitude = static_cast<int>(std::sqrt(gradX.pixels[i] * gradX.pixels[i] + gradY.pixels[i] * gradY.pixels[i]));
-        output.pixels[i] = static_cast<unsigned char>(std::clamp(magnitude, 0, 255));
+    for (unsigned int y = 0; y < input.getHeight(); ++y) {
+        sobelRowScalar(input, output, y, 0, input.getWidth(), norm);
     }
+}
 
-    return output;
+// Sobel magnitude of a single pixel. Gives exactly the value sobel() produces at (x, y),
+// which lets callers refresh a small region of an energy map without a full pass.
+unsigned char CustomImageFilter::sobelAt(const ImageData& input, unsigned int x, unsigned int y, EnergyNorm norm) {
+    const int width = static_cast<int>(input.getWidth());
+    const int height = static_cast<int>(input.getHeight());
+    const int ix = static_cast<int>(x);
+    const int iy = static_cast<int>(y);
+    return sobelMagnitude(input.getRow(mirror(iy - 1, height)), input.getRow(y), input.getRow(mirror(iy + 1, height)),
+                          mirror(ix - 1, width), ix, mirror(ix + 1, width), norm);
+}
+
+// Cumulative energy for columns [xBegin, xEnd) of row y >= 1, reading row y - 1 of the map.
+// The interior goes through the SIMD kernel, the image edges and the remainder are scalar.
+template <typename Cost>
+static void minimalEnergyRow(const ImageData& energyMap, Cost* minimalEnergyPathMap, unsigned int y,
+                             unsigned int xBegin, unsigned int xEnd, SimdLevel level) {
+    const unsigned int width = energyMap.getWidth();
+    const Cost* above = minimalEnergyPathMap + (y - 1) * width;
+    Cost* current = minimalEnergyPathMap + y * width;
+    const unsigned char* energy = energyMap.getRow(y);
+
+    auto scalarAt = [&](unsigned int x) {
+        // Directly above
+        Cost minEnergy = above[x];
+        // Above-left
+        if (x > 0) minEnergy = std::min(minEnergy, above[x - 1]);
+        // Above-right
+        if (x + 1 < width) minEnergy = std::min(minEnergy, above[x + 1]);
+
+        // Update the cumulative energy for the current pixel
+        current[x] = static_cast<Cost>(energy[x] + minEnergy);
+    };
+
+    unsigned int x = xBegin;
+    if (x == 0 && x < xEnd) scalarAt(x++);
+    const unsigned int interiorEnd = std::min(xEnd, width - 1);
+    if (x < interiorEnd) x = simd::minimalEnergyRow(level, above, energy, current, x, interiorEnd);
+    for (; x < xEnd; ++x) scalarAt(x);
+}
+
+// Same row, also storing the backtrack step of every column in 'directions' (same layout as the map)
+static void minimalEnergyRow(const ImageData& energyMap, unsigned int* minimalEnergyPathMap, int8_t* directions,
+                             unsigned int y, unsigned int xBegin, unsigned int xEnd, SimdLevel level) {
+    const unsigned int width = energyMap.getWidth();
+    const unsigned int* above = minimalEnergyPathMap + (y - 1) * width;
+    unsigned int* current = minimalEnergyPathMap + y * width;
+    int8_t* step = directions + y * width;
+    const unsigned char* energy = energyMap.getRow(y);
+
+    // Same preference as identityMinEnergySeam: above, then strictly cheaper left / right
+    auto scalarAt = [&](unsigned int x) {
+        unsigned int minEnergy = above[x];
+        int8_t minStep = 0;
+        if (x > 0 && above[x - 1] < minEnergy) minEnergy = above[x - 1], minStep = -1;
+        if (x + 1 < width && above[x + 1] < minEnergy) minEnergy = above[x + 1], minStep = 1;
+        current[x] = static_cast<unsigned int>(energy[x]) + minEnergy;
+        step[x] = minStep;
+    };
+
+    unsigned int x = xBegin;
+    if (x == 0 && x < xEnd) scalarAt(x++);
+    const unsigned int interiorEnd = std::min(xEnd, width - 1);
+    if (x < interiorEnd) x = simd::minimalEnergyRow(level, above, energy, current, step, x, interiorEnd);
+    for (; x < xEnd; ++x) scalarAt(x);
+}
+
+// Rows per synchronization step of the parallel DP, and the smallest map worth splitting
+static constexpr unsigned int kDpBandRows = 32;
+static constexpr size_t kDpParallelMinPixels = 256 * 256;
+
+// Each row only depends on the row above, so rows are split into column chunks that
+// run in parallel. To avoid a barrier per row, bands of kDpBandRows rows are filled
+// in two steps (trapezoid tiling):
+//  1. every chunk computes a trapezoid that shrinks by one column per row at each
+//     inner chunk border, which only needs values from the chunk itself;
+//  2. the inverted triangles left around every chunk border are filled, they only
+//     need the trapezoids next to them.
+// Chunks are at least 2 * kDpBandRows wide so the triangles never overlap.
+// 'row(y, xBegin, xEnd)' fills one row segment from the row above (row 0 is done by the caller).
+template <typename RowFn>
+static void fillPathMapRows(unsigned int width, unsigned int height, ThreadPool& pool, const RowFn& row) {
+    const unsigned int chunks = std::min(pool.getThreadCount(), width / (2 * kDpBandRows));
+
+    if (chunks < 2 || static_cast<size_t>(width) * height < kDpParallelMinPixels) {
+        // Fill in the cumulative energy map row by row
+        for (unsigned int y = 1; y < height; ++y) row(y, 0, width);
+        return;
+    }
+
+    std::vector<unsigned int> bounds(chunks + 1);
+    for (unsigned int c = 0; c <= chunks; ++c) bounds[c] = static_cast<unsigned int>(static_cast<size_t>(c) * width / chunks);
+
+    for (unsigned int y0 = 0; y0 + 1 < height; y0 += kDpBandRows) {
+        const unsigned int rows = std::min(kDpBandRows, height - 1 - y0);
+
+        // 1. Trapezoids (image borders do not shrink)
+        pool.parallelFor(chunks, [&](unsigned int c) {
+            for (unsigned int k = 1; k <= rows; ++k) {
+                unsigned int xBegin = bounds[c] + (c > 0 ? k : 0);
+                unsigned int xEnd = bounds[c + 1] - (c + 1 < chunks ? k : 0);
+                row(y0 + k, xBegin, xEnd);
+            }
+        });
+
+        // 2. Triangles around the inner chunk borders
+        pool.parallelFor(chunks - 1, [&](unsigned int i) {
+            const unsigned int border = bounds[i + 1];
+            for (unsigned int k = 1; k <= rows; ++k) row(y0 + k, border - k, border + k);
+        });
+    }
 }
 
 // Compute the minimal energy path map using dynamic programming
-std::vector<unsigned int> CustomImageFilter::computeMinimalEnergyPathMap(ImageData& energyMap) {
+std::vector<unsigned int> CustomImageFilter::computeMinimalEnergyPathMap(const ImageData& energyMap) {
+    return computeMinimalEnergyPathMap(energyMap, ThreadPool::shared());
+}
+
+std::vector<unsigned int> CustomImageFilter::computeMinimalEnergyPathMap(const ImageData& energyMap, ThreadPool& pool) {
+    return computeCostMap<unsigned int>(energyMap, pool);
+}
+
+std::vector<unsigned int> CustomImageFilter::computeMinimalEnergyPathMap(const ImageData& energyMap, std::vector<int8_t>& directions,
+                                                                         ThreadPool& pool) {
+    const unsigned int width = energyMap.getWidth();
+    const unsigned int height = energyMap.getHeight();
+
+    std::vector<unsigned int> minimalEnergyPathMap(static_cast<size_t>(width) * height);
+    // Row 0 has no upper neighbour, its steps stay 0
+    directions.assign(minimalEnergyPathMap.size(), 0);
+    if (width == 0 || height == 0) return minimalEnergyPathMap;
+
+    for (unsigned int x = 0; x < width; ++x) {
+        minimalEnergyPathMap[x] = static_cast<unsigned int>(energyMap.getRow(0)[x]);
+    }
+
+    const SimdLevel level = getSimdLevel();
+    unsigned int* map = minimalEnergyPathMap.data();
+    int8_t* steps = directions.data();
+    fillPathMapRows(width, height, pool, [&](unsigned int y, unsigned int xBegin, unsigned int xEnd) {
+        minimalEnergyRow(energyMap, map, steps, y, xBegin, xEnd, level);
+    });
+    return minimalEnergyPathMap;
+}
+
+template <typename Cost>
+std::vector<Cost> CustomImageFilter::computeCostMap(const ImageData& energyMap, ThreadPool& pool) {
+    const unsigned int width = energyMap.getWidth();
+    const unsigned int height = energyMap.getHeight();
+
     // Create a 2D vector to store the cumulative energy values
-    std::vector<unsigned int> minimalEnergyPathMap(energyMap.getWidth() * energyMap.getHeight());
+    std::vector<Cost> minimalEnergyPathMap(static_cast<size_t>(width) * height);
+    if (width == 0 || height == 0) return minimalEnergyPathMap;
+    if (!costFits<Cost>(height)) {
+        spdlog::error("computeCostMap: {} rows overflow a {} bit cost map.", height, sizeof(Cost) * 8);
+        return {};
+    }
 
     // Copy first row of energy map to cumulative energy map
-    for (unsigned int x = 0; x < energyMap.getWidth(); ++x) {
-        minimalEnergyPathMap[x] = static_cast<unsigned int>(energyMap.pixels[x]);
+    for (unsigned int x = 0; x < width; ++x) {
+        minimalEnergyPathMap[x] = static_cast<Cost>(energyMap.getRow(0)[x]);
     }
 
-    // Fill in the cumulative energy map
-    for (int y = 1; y < energyMap.getHeight(); ++y) {
-        for (int x = 0; x < energyMap.getWidth(); ++x) {
-            unsigned int idx = y * energyMap.getWidth() + x;
-            unsigned int above = (y - 1) * energyMap.getWidth() + x;
+    const SimdLevel level = getSimdLevel();
+    Cost* map = minimalEnergyPathMap.data();
+    fillPathMapRows(width, height, pool, [&](unsigned int y, unsigned int xBegin, unsigned int xEnd) {
+        minimalEnergyRow(energyMap, map, y, xBegin, xEnd, level);
+    });
+    return minimalEnergyPathMap;
+}
 
-            // Directly above
-            unsigned int minEnergy = minimalEnergyPathMap[above];
-            // Above-left
-            if (x - 1 >= 0) {
-                minEnergy = std::min(minEnergy, minimalEnergyPathMap[above - 1]);
-            }
-            // Above-right
-            if (x + 1 < static_cast<int>(energyMap.getWidth())) {
-                minEnergy = std::min(minEnergy, minimalEnergyPathMap[above + 1]);
-            }
+// The cone below the changed energy: row y is recomputed in its seed interval plus one
+// column around the columns whose value changed in row y - 1. Where the recomputed
+// values equal the stored ones the cone stops spreading.
+size_t CustomImageFilter::updateMinimalEnergyPathMap(const ImageData& energyMap, std::vector<unsigned int>& minimalEnergyPathMap,
+                                                     const std::vector<unsigned int>& dirtyBegin,
+                                                     const std::vector<unsigned int>& dirtyEnd) {
+    const unsigned int width = energyMap.getWidth();
+    const unsigned int height = energyMap.getHeight();
+    if (minimalEnergyPathMap.size() != static_cast<size_t>(width) * height || dirtyBegin.size() != height || dirtyEnd.size() != height) {
+        spdlog::error("updateMinimalEnergyPathMap: map or dirty rows do not match the {}x{} energy map.", width, height);
+        return 0;
+    }
+
+    const SimdLevel level = getSimdLevel();
+    std::vector<unsigned int> previous(width); // Stored values of the recomputed segment
+    unsigned int changedBegin = 0, changedEnd = 0; // Columns that changed in the row above
+    size_t cells = 0;
+    for (unsigned int y = 0; y < height; ++y) {
+        unsigned int xBegin = std::min(dirtyBegin[y], width);
+        unsigned int xEnd = std::min(dirtyEnd[y], width);
+        if (changedBegin < changedEnd) {
+            const unsigned int coneBegin = changedBegin > 0 ? changedBegin - 1 : 0;
+            const unsigned int coneEnd = std::min(width, changedEnd + 1);
+            xBegin = xBegin < xEnd ? std::min(xBegin, coneBegin) : coneBegin;
+            xEnd = std::max(xEnd, coneEnd);
+        }
+        changedBegin = changedEnd = 0;
+        if (xBegin >= xEnd) continue;
+
+        unsigned int* row = minimalEnergyPathMap.data() + static_cast<size_t>(y) * width;
+        std::copy(row + xBegin, row + xEnd, previous.begin() + xBegin);
+        if (y == 0) {
+            const unsigned char* energy = energyMap.getRow(0);
+            for (unsigned int x = xBegin; x < xEnd; ++x) row[x] = energy[x];
+        } else {
+            minimalEnergyRow(energyMap, minimalEnergyPathMap.data(), y, xBegin, xEnd, level);
+        }
+        cells += xEnd - xBegin;
 
-            // Update the cumulative energy for the current pixel
-            minimalEnergyPathMap[idx] = static_cast<unsigned int>(energyMap.pixels[idx]) + minEnergy;
+        for (unsigned int x = xBegin; x < xEnd; ++x) {
+            if (row[x] == previous[x]) continue;
+            if (changedBegin == changedEnd) changedBegin = x;
+            changedEnd = x + 1;
         }
     }
+    return cells;
+}
 
-    return minimalEnergyPathMap;
+// Band cells that cannot be reached from the row above. Half the range, so adding the
+// energy of a whole column (height * 255) can never wrap around.
+static constexpr unsigned int kUnreachable = std::numeric_limits<unsigned int>::max() / 2;
+
+std::vector<unsigned int> CustomImageFilter::computeMinimalEnergyPathMapInBand(const ImageData& energyMap,
+                                                                               const std::vector<unsigned int>& bandStart,
+                                                                               unsigned int bandWidth) {
+    const unsigned int width = energyMap.getWidth();
+    const unsigned int height = energyMap.getHeight();
+    std::vector<unsigned int> bandMap(static_cast<size_t>(bandWidth) * height);
+    if (width == 0 || height == 0 || bandWidth == 0) return bandMap;
+    if (bandStart.size() != height || bandWidth > width) {
+        spdlog::error("computeMinimalEnergyPathMapInBand: band does not match the {}x{} energy map.", width, height);
+        return {};
+    }
+
+    const unsigned char* energy = energyMap.getRow(0) + bandStart[0];
+    for (unsigned int i = 0; i < bandWidth; ++i) bandMap[i] = energy[i];
+
+    // Row y - 1 of the map re-based to the band of row y, one column of margin on both sides:
+    // above[i] is column bandStart[y] - 1 + i, so the unbounded row kernel applies as is
+    std::vector<unsigned int> above(bandWidth + 2);
+    const SimdLevel level = getSimdLevel();
+    for (unsigned int y = 1; y < height; ++y) {
+        const unsigned int start = std::min(bandStart[y], width - bandWidth);
+        const unsigned int prevStart = std::min(bandStart[y - 1], width - bandWidth);
+        const unsigned int* prev = bandMap.data() + static_cast<size_t>(y - 1) * bandWidth;
+        for (unsigned int i = 0; i < bandWidth + 2; ++i) {
+            const long long x = static_cast<long long>(start) + i - 1 - prevStart;
+            above[i] = x >= 0 && x < bandWidth ? prev[x] : kUnreachable;
+        }
+
+        // Columns 1 .. bandWidth of the kernel are band cells 0 .. bandWidth - 1
+        const unsigned char* row = energyMap.getRow(y) + start - 1;
+        unsigned int* out = bandMap.data() + static_cast<size_t>(y) * bandWidth - 1;
+        unsigned int x = simd::minimalEnergyRow(level, above.data(), row, out, 1, bandWidth + 1);
+        for (; x <= bandWidth; ++x) {
+            out[x] = static_cast<unsigned int>(row[x]) + std::min({above[x - 1], above[x], above[x + 1]});
+        }
+    }
+    return bandMap;
+}
+
+// Max pooling keeps thin high energy edges visible in the coarse levels (an average would
+// fade them by 4 per level), so coarse seams still avoid them.
+ImageData CustomImageFilter::downsampleMax2(const ImageData& energyMap) {
+    const unsigned int width = energyMap.getWidth();
+    const unsigned int height = energyMap.getHeight();
+    const unsigned int coarseWidth = (width + 1) / 2;
+    const unsigned int coarseHeight = (height + 1) / 2;
+    ImageData coarse(coarseWidth, coarseHeight, 1, RowLayout::Aligned);
+
+    const SimdLevel level = getSimdLevel();
+    for (unsigned int cy = 0; cy < coarseHeight; ++cy) {
+        const unsigned char* row0 = energyMap.getRow(2 * cy);
+        const unsigned char* row1 = 2 * cy + 1 < height ? energyMap.getRow(2 * cy + 1) : row0;
+        unsigned char* out = coarse.getRow(cy);
+        // Full pairs only in the kernel, the odd last column is clamped below
+        unsigned int x = simd::downsampleMax2Row(level, row0, row1, out, width / 2);
+        for (; x < coarseWidth; ++x) {
+            const unsigned int x1 = std::min(2 * x + 1, width - 1);
+            out[x] = std::max({row0[2 * x], row0[x1], row1[2 * x], row1[x1]});
+        }
+    }
+    return coarse;
+}
+
+// Forward energy (Rubinstein et al. 2008): instead of the energy of the removed pixel,
+// a step costs the gradient magnitude of the new edges it creates between pixels that
+// become neighbours once the seam is gone. For pixel (x, y) with L/R/U = left, right
+// and upper neighbour in the greyscale image (clamped at the borders):
+//   cU = |R - L|            coming from (x, y-1)
+//   cL = cU + |U - L|       coming from (x-1, y-1)
+//   cR = cU + |U - R|       coming from (x+1, y-1)
+// Returns the cumulative cost and the chosen step (-1, 0, +1). The preference order
+// (above, then strictly cheaper left, then strictly cheaper right) matches
+// identityMinEnergySeam, and the backtrack replays exactly this decision.
+static inline unsigned int forwardEnergyStep(const unsigned int* above, const unsigned char* up, const unsigned char* mid,
+                                             unsigned int x, unsigned int width, int& step) {
+    const int l = mid[x > 0 ? x - 1 : x];
+    const int r = mid[x + 1 < width ? x + 1 : x];
+    const int u = up[x];
+    const unsigned int cU = static_cast<unsigned int>(std::abs(r - l));
+
+    unsigned int best = above[x] + cU;
+    step = 0;
+    if (x > 0) {
+        const unsigned int left = above[x - 1] + cU + static_cast<unsigned int>(std::abs(u - l));
+        if (left < best) { best = left; step = -1; }
+    }
+    if (x + 1 < width) {
+        const unsigned int right = above[x + 1] + cU + static_cast<unsigned int>(std::abs(u - r));
+        if (right < best) { best = right; step = 1; }
+    }
+    return best;
+}
+
+// Forward energy cumulative cost: fused into the DP, reads two greyscale rows and the
+// previous cost row per output row (no Sobel pass or energy buffer)
+static void forwardEnergyRow(const ImageData& greyscale, unsigned int* map, unsigned int y, unsigned int xBegin, unsigned int xEnd,
+                             SimdLevel level) {
+    const unsigned int width = greyscale.getWidth();
+    const unsigned int* above = map + static_cast<size_t>(y - 1) * width;
+    unsigned int* current = map + static_cast<size_t>(y) * width;
+    const unsigned char* up = greyscale.getRow(y - 1);
+    const unsigned char* mid = greyscale.getRow(y);
+
+    unsigned int x = xBegin;
+    int step;
+    if (x == 0 && x < xEnd) { current[0] = forwardEnergyStep(above, up, mid, 0, width, step); ++x; }
+    // Interior without border checks
+    const unsigned int interiorEnd = std::min(xEnd, width - 1);
+    if (x < interiorEnd) x = simd::forwardEnergyRow(level, above, up, mid, current, x, interiorEnd);
+    for (; x < interiorEnd; ++x) {
+        const int l = mid[x - 1];
+        const int r = mid[x + 1];
+        const int u = up[x];
+        const unsigned int cU = static_cast<unsigned int>(std::abs(r - l));
+        const unsigned int left = above[x - 1] + static_cast<unsigned int>(std::abs(u - l));
+        const unsigned int right = above[x + 1] + static_cast<unsigned int>(std::abs(u - r));
+        current[x] = cU + std::min(above[x], std::min(left, right));
+    }
+    for (; x < xEnd; ++x) current[x] = forwardEnergyStep(above, up, mid, x, width, step);
+}
+
+std::vector<unsigned int> CustomImageFilter::computeForwardEnergyPathMap(const ImageData& greyscale) {
+    return computeForwardEnergyPathMap(greyscale, ThreadPool::shared());
+}
+
+std::vector<unsigned int> CustomImageFilter::computeForwardEnergyPathMap(const ImageData& greyscale, ThreadPool& pool) {
+    const unsigned int width = greyscale.getWidth();
+    const unsigned int height = greyscale.getHeight();
+
+    std::vector<unsigned int> forwardEnergyPathMap(static_cast<size_t>(width) * height);
+    if (width == 0 || height == 0) return forwardEnergyPathMap;
+
+    // First row: only the new horizontal neighbour edge
+    const unsigned char* row0 = greyscale.getRow(0);
+    for (unsigned int x = 0; x < width; ++x) {
+        const int l = row0[x > 0 ? x - 1 : x];
+        const int r = row0[x + 1 < width ? x + 1 : x];
+        forwardEnergyPathMap[x] = static_cast<unsigned int>(std::abs(r - l));
+    }
+
+    const SimdLevel level = getSimdLevel();
+    unsigned int* map = forwardEnergyPathMap.data();
+    fillPathMapRows(width, height, pool, [&](unsigned int y, unsigned int xBegin, unsigned int xEnd) {
+        forwardEnergyRow(greyscale, map, y, xBegin, xEnd, level);
+    });
+    return forwardEnergyPathMap;
+}
+
+// Transition costs depend on the greyscale image, so the seam is found by replaying the
+// DP decision per row instead of comparing the neighbours above
+std::vector<unsigned int> CustomImageFilter::identityForwardEnergySeam(const std::vector<unsigned int>& forwardEnergyPathMap, const ImageData& greyscale) {
+    const unsigned int width = greyscale.getWidth();
+    const unsigned int height = greyscale.getHeight();
+    std::vector<unsigned int> seamPixelIndices;
+    if (width == 0 || height == 0) return seamPixelIndices;
+    seamPixelIndices.reserve(height);
+
+    auto lastRowStart = forwardEnergyPathMap.end() - width;
+    unsigned int seamPosX = static_cast<unsigned int>(std::distance(lastRowStart, std::min_element(lastRowStart, forwardEnergyPathMap.end())));
+    seamPixelIndices.push_back((height - 1) * width + seamPosX);
+
+    for (unsigned int y = height - 1; y > 0; --y) {
+        int step;
+        forwardEnergyStep(forwardEnergyPathMap.data() + static_cast<size_t>(y - 1) * width,
+                          greyscale.getRow(y - 1), greyscale.getRow(y), seamPosX, width, step);
+        seamPosX += step;
+        seamPixelIndices.push_back((y - 1) * width + seamPosX);
+    }
+
+    return seamPixelIndices;
 }
 
 std::vector<unsigned int> CustomImageFilter::identityMinEnergySeam(const std::vector<unsigned int>& minPathEnergyMap, unsigned int imageWidth, unsigned int imageHeight) {
+    return backtrackCostMap(minPathEnergyMap, imageWidth, imageHeight);
+}
+
+template <typename Cost>
+std::vector<unsigned int> CustomImageFilter::backtrackCostMap(const std::vector<Cost>& minPathEnergyMap, unsigned int imageWidth, unsigned int imageHeight) {
     // Placeholder for dynamic programming seam calculation implementation
 
     // Step 3: Remove the seam from the image
@@ -166,9 +706,7 @@ std::vector<unsigned int> CustomImageFilter::identityMinEnergySeam(const std::ve
         unsigned int pixelAbove = (currRow-1) * imageWidth + seamPosX;
 
         // Determine the next seam position
-        std::vector<std::pair<int, unsigned int>> candidates; // pair of (x offset, energy)
-        
-        unsigned int minNextEnergyPath = minPathEnergyMap[pixelAbove]; // directly above
+        Cost minNextEnergyPath = minPathEnergyMap[pixelAbove]; // directly above
         char minNextIndex = 0;
         
         if((seamPosX - 1) >= 0){
@@ -193,24 +731,603 @@ std::vector<unsigned int> CustomImageFilter::identityMinEnergySeam(const std::ve
     return seamPixelIndices;
 }
 
+// Pointer chase through the steps stored by the DP: one byte read per row
+static constexpr unsigned int kTracePrefetchRows = 16;
+
+std::vector<unsigned int> CustomImageFilter::traceSeamColumns(const std::vector<int8_t>& directions, unsigned int imageWidth,
+                                                              unsigned int imageHeight, unsigned int lastColumn) {
+    std::vector<unsigned int> columns;
+    if (imageHeight == 0 || lastColumn >= imageWidth || directions.size() != static_cast<size_t>(imageWidth) * imageHeight) {
+        spdlog::error("traceSeamColumns: column {} or directions do not match a {}x{} map.", lastColumn, imageWidth, imageHeight);
+        return columns;
+    }
+    columns.resize(imageHeight);
+    unsigned int x = lastColumn;
+    for (unsigned int y = imageHeight - 1; y > 0; --y) {
+        columns[y] = x;
+#if defined(__GNUC__) || defined(__clang__)
+        // Every row is a cache miss that depends on the previous one; the seam drifts at most
+        // one column per row, so the line kTracePrefetchRows rows up is almost surely needed
+        if (y >= kTracePrefetchRows) __builtin_prefetch(directions.data() + static_cast<size_t>(y - kTracePrefetchRows) * imageWidth + x);
+#endif
+        x += directions[static_cast<size_t>(y) * imageWidth + x];
+    }
+    columns[0] = x;
+    return columns;
+}
+
+std::vector<unsigned int> CustomImageFilter::identityMinEnergySeamColumns(const std::vector<unsigned int>& minPathEnergyMap,
+                                                                          const std::vector<int8_t>& directions,
+                                                                          unsigned int imageWidth, unsigned int imageHeight) {
+    if (imageWidth == 0 || imageHeight == 0 || minPathEnergyMap.size() != static_cast<size_t>(imageWidth) * imageHeight) return {};
+    auto lastRowStart = minPathEnergyMap.end() - imageWidth;
+    const unsigned int lastColumn = static_cast<unsigned int>(std::min_element(lastRowStart, minPathEnergyMap.end()) - lastRowStart);
+    return traceSeamColumns(directions, imageWidth, imageHeight, lastColumn);
+}
+
+template std::vector<uint16_t> CustomImageFilter::computeCostMap<uint16_t>(const ImageData&, ThreadPool&);
+template std::vector<unsigned int> CustomImageFilter::computeCostMap<unsigned int>(const ImageData&, ThreadPool&);
+template std::vector<unsigned int> CustomImageFilter::backtrackCostMap<uint16_t>(const std::vector<uint16_t>&, unsigned int, unsigned int);
+template std::vector<unsigned int> CustomImageFilter::backtrackCostMap<unsigned int>(const std::vector<unsigned int>&, unsigned int, unsigned int);
+
+// Short maps run in 16 bit: half the memory traffic and twice the SIMD lanes per row
+std::vector<unsigned int> CustomImageFilter::findMinEnergySeam(const ImageData& energyMap, ThreadPool& pool) {
+    const unsigned int width = energyMap.getWidth();
+    const unsigned int height = energyMap.getHeight();
+    if (width == 0 || height == 0) return {};
+    if (costFits<uint16_t>(height)) return backtrackCostMap(computeCostMap<uint16_t>(energyMap, pool), width, height);
+    return backtrackCostMap(computeCostMap<unsigned int>(energyMap, pool), width, height);
+}
+
+std::vector<unsigned int> CustomImageFilter::findMinEnergySeam(const ImageData& energyMap) {
+    return findMinEnergySeam(energyMap, ThreadPool::shared());
+}
+
+std::vector<unsigned int> CustomImageFilter::identityMinEnergySeamInBand(const std::vector<unsigned int>& bandMap,
+                                                                         const std::vector<unsigned int>& bandStart,
+                                                                         unsigned int bandWidth, unsigned int imageWidth,
+                                                                         unsigned int imageHeight) {
+    std::vector<unsigned int> seamPixelIndices;
+    if (bandWidth == 0 || imageHeight == 0 || bandMap.size() != static_cast<size_t>(bandWidth) * imageHeight) return seamPixelIndices;
+    seamPixelIndices.reserve(imageHeight);
+    auto startOf = [&](unsigned int y) { return std::min(bandStart[y], imageWidth - bandWidth); };
+
+    // Cheapest cell of the last band row (leftmost on ties, like identityMinEnergySeam)
+    const unsigned int* last = bandMap.data() + static_cast<size_t>(imageHeight - 1) * bandWidth;
+    unsigned int seamPosX = startOf(imageHeight - 1) + static_cast<unsigned int>(std::min_element(last, last + bandWidth) - last);
+    seamPixelIndices.push_back((imageHeight - 1) * imageWidth + seamPosX);
+
+    for (unsigned int y = imageHeight - 1; y > 0; --y) {
+        const unsigned int start = startOf(y - 1);
+        const unsigned int* above = bandMap.data() + static_cast<size_t>(y - 1) * bandWidth;
+        auto valueAt = [&](long long x) {
+            return x >= start && x < static_cast<long long>(start) + bandWidth ? above[x - start] : kUnreachable;
+        };
+
+        // Same preference as identityMinEnergySeam: above, then strictly cheaper left / right
+        long long next = seamPosX;
+        unsigned int minEnergy = valueAt(next);
+        if (seamPosX > 0 && valueAt(seamPosX - 1ll) < minEnergy) {
+            minEnergy = valueAt(seamPosX - 1ll);
+            next = seamPosX - 1ll;
+        }
+        if (seamPosX + 1 < imageWidth && valueAt(seamPosX + 1ll) < minEnergy) next = seamPosX + 1ll;
+
+        seamPosX = static_cast<unsigned int>(next);
+        seamPixelIndices.push_back((y - 1) * imageWidth + seamPosX);
+    }
+    return seamPixelIndices;
+}
+
+// Greedy extraction of several pixel-disjoint seams from one cumulative map.
+// Bottom row pixels are tried in order of increasing cumulative energy. Each seam is
+// backtracked like identityMinEnergySeam but may not step onto pixels already taken
+// by a previous seam; a seam that runs into taken pixels only is dropped. The first
+// seam is exactly the one identityMinEnergySeam returns.
+std::vector<std::vector<unsigned int>> CustomImageFilter::identityMinEnergySeams(const std::vector<unsigned int>& minPathEnergyMap,
+                                                                                 unsigned int imageWidth, unsigned int imageHeight,
+                                                                                 unsigned int seamCount) {
+    std::vector<std::vector<unsigned int>> seams;
+    if (imageWidth == 0 || imageHeight == 0 || seamCount == 0) return seams;
+    seamCount = std::min(seamCount, imageWidth - 1);
+
+    // Candidate start columns, cheapest first (stable: leftmost wins ties)
+    const unsigned int lastRow = (imageHeight - 1) * imageWidth;
+    std::vector<unsigned int> starts(imageWidth);
+    for (unsigned int x = 0; x < imageWidth; ++x) starts[x] = x;
+    std::stable_sort(starts.begin(), starts.end(), [&](unsigned int a, unsigned int b) {
+        return minPathEnergyMap[lastRow + a] < minPathEnergyMap[lastRow + b];
+    });
+
+    std::vector<unsigned char> taken(minPathEnergyMap.size(), 0);
+    std::vector<unsigned int> seam;
+    seam.reserve(imageHeight);
+
+    for (unsigned int start : starts) {
+        if (seams.size() == seamCount) break;
+        if (taken[lastRow + start]) continue;
+
+        seam.clear();
+        int seamPosX = static_cast<int>(start);
+        seam.push_back(lastRow + seamPosX);
+
+        bool blocked = false;
+        for (int currRow = static_cast<int>(imageHeight) - 1; currRow > 0; --currRow) {
+            const unsigned int rowAbove = (currRow - 1) * imageWidth;
+
+            // Same preference as identityMinEnergySeam: above, then strictly cheaper left / right
+            int next = -1;
+            for (int offset : {0, -1, 1}) {
+                int x = seamPosX + offset;
+                if (x < 0 || x >= static_cast<int>(imageWidth) || taken[rowAbove + x]) continue;
+                if (next < 0 || minPathEnergyMap[rowAbove + x] < minPathEnergyMap[rowAbove + next]) next = x;
+            }
+            if (next < 0) {
+                blocked = true;
+                break;
+            }
+            seamPosX = next;
+            seam.push_back(rowAbove + seamPosX);
+        }
+        if (blocked) continue;
+
+        for (auto pixelIndex : seam) taken[pixelIndex] = 1;
+        seams.push_back(seam);
+    }
+
+    return seams;
+}
+
+// Convert flat seam pixel indices (one per row, any row order) to one column per row.
+// Returns false if the seam does not cover every row exactly once.
+static bool seamToColumns(const std::vector<unsigned int>& seam, unsigned int width, unsigned int height,
+                          std::vector<unsigned int>& columns) {
+    if (seam.size() != height || width == 0) return false;
+    columns.assign(height, width); // 'width' marks an unvisited row
+    for (auto pixelIndex : seam) {
+        unsigned int row = pixelIndex / width;
+        if (row >= height || columns[row] != width) return false;
+        columns[row] = pixelIndex % width;
+    }
+    return true;
+}
+
+// Compact the rows of an interleaved buffer in a single forward sweep, dropping
+// 'count' pixels per row. 'removed' holds count sorted, distinct columns per row
+// (row-major). Rows are read with 'srcPitch' and written with 'dstPitch' elements
+// per row: equal pitches shift each row in place (pitched images), a smaller
+// destination pitch repacks the buffer. Every byte is moved at most once and the
+// write position never passes the read position, so this works in place.
+template <typename T>
+static void compactRows(T* data, unsigned int width, unsigned int height, unsigned int channels,
+                        size_t srcPitch, size_t dstPitch, const unsigned int* removed, unsigned int count) {
+    for (unsigned int y = 0; y < height; ++y) {
+        const T* row = data + y * srcPitch;
+        T* write = data + y * dstPitch;
+        unsigned int segmentBegin = 0;
+        for (unsigned int i = 0; i < count; ++i) {
+            unsigned int col = removed[y * count + i];
+            size_t segment = static_cast<size_t>(col - segmentBegin) * channels;
+            std::memmove(write, row + static_cast<size_t>(segmentBegin) * channels, segment * sizeof(T));
+            write += segment;
+            segmentBegin = col + 1;
+        }
+        size_t tail = static_cast<size_t>(width - segmentBegin) * channels;
+        std::memmove(write, row + static_cast<size_t>(segmentBegin) * channels, tail * sizeof(T));
+    }
+}
+
+// Remove 'count' pixels per row from an image, keeping its row layout. Packed
+// images are repacked, aligned images only shift each row and keep their stride.
+static void compactImage(ImageData& image, const unsigned int* removed, unsigned int count) {
+    const unsigned int newWidth = image.getWidth() - count;
+    const size_t srcPitch = image.getRowPitch();
+    // Layout, not isPacked(): an aligned image whose width fills the stride keeps its stride
+    const size_t dstPitch = image.getLayout() == RowLayout::Packed ? static_cast<size_t>(newWidth) * image.getChannels() : srcPitch;
+    compactRows(image.pixels.data(), image.getWidth(), image.getHeight(), image.getChannels(),
+                srcPitch, dstPitch, removed, count);
+
+    // Shrinking never reallocates the pixel buffer
+    image.setWidth(newWidth);
+}
+
 void CustomImageFilter::removeSeam(ImageData& image, const std::vector<unsigned int>& seam) {
+    std::vector<unsigned int> columns;
+    if (!seamToColumns(seam, image.getWidth(), image.getHeight(), columns)) {
+        spdlog::error("removeSeam: seam does not match a {}x{} image.", image.getWidth(), image.getHeight());
+        return;
+    }
 
-    for(auto pixelIndex : seam) {
-        image.pixels.erase(image.pixels.begin() + pixelIndex * image.getChannels(), image.pixels.begin() + (pixelIndex + 1) * image.getChannels());
+    compactImage(image, columns.data(), 1);
+}
+
+void CustomImageFilter::removeSeamColumns(ImageData& image, const std::vector<unsigned int>& columns) {
+    const unsigned int width = image.getWidth();
+    if (columns.size() != image.getHeight() || width == 0 ||
+        std::any_of(columns.begin(), columns.end(), [&](unsigned int x) { return x >= width; })) {
+        spdlog::error("removeSeamColumns: seam does not match a {}x{} image.", width, image.getHeight());
+        return;
+    }
+
+    compactImage(image, columns.data(), 1);
+}
+
+// Gather the removed columns of every row (row-major, 'seams.size()' per row), sorted
+// left to right. Returns false (and logs) for invalid or overlapping seams.
+static bool collectRemovedColumns(const std::vector<std::vector<unsigned int>>& seams, unsigned int width,
+                                  unsigned int height, std::vector<unsigned int>& removed) {
+    const unsigned int count = static_cast<unsigned int>(seams.size());
+    if (count >= width) {
+        spdlog::error("removeSeams: cannot remove {} seams from an image of width {}.", count, width);
+        return false;
+    }
+
+    removed.resize(static_cast<size_t>(height) * count);
+    std::vector<unsigned int> columns;
+    for (unsigned int i = 0; i < count; ++i) {
+        if (!seamToColumns(seams[i], width, height, columns)) {
+            spdlog::error("removeSeams: seam {} does not match a {}x{} image.", i, width, height);
+            return false;
+        }
+        for (unsigned int y = 0; y < height; ++y) removed[y * count + i] = columns[y];
+    }
+    for (unsigned int y = 0; y < height; ++y) {
+        auto rowBegin = removed.begin() + y * count;
+        std::sort(rowBegin, rowBegin + count);
+        if (std::adjacent_find(rowBegin, rowBegin + count) != rowBegin + count) {
+            spdlog::error("removeSeams: seams overlap in row {}.", y);
+            return false;
+        }
+    }
+    return true;
+}
+
+void CustomImageFilter::removeSeams(ImageData& image, const std::vector<std::vector<unsigned int>>& seams) {
+    if (seams.empty()) return;
+
+    std::vector<unsigned int> removed;
+    if (!collectRemovedColumns(seams, image.getWidth(), image.getHeight(), removed)) return;
+
+    compactImage(image, removed.data(), static_cast<unsigned int>(seams.size()));
+}
+
+void CustomImageFilter::removeSeams(std::vector<unsigned int>& values, unsigned int width, unsigned int height,
+                                    const std::vector<std::vector<unsigned int>>& seams) {
+    if (seams.empty()) return;
+
+    std::vector<unsigned int> removed;
+    if (!collectRemovedColumns(seams, width, height, removed)) return;
+
+    const unsigned int count = static_cast<unsigned int>(seams.size());
+    compactRows(values.data(), width, height, 1, width, width - count, removed.data(), count);
+    values.resize(static_cast<size_t>(width - count) * height);
+}
+
+// Keep the pixels that survive the first (width - targetWidth) seam removals: exactly
+// targetWidth pixels per row have a removal order of at least that many seams.
+ImageData CustomImageFilter::applySeamOrder(const ImageData& source, const unsigned int* removalOrder, unsigned int targetWidth) {
+    const unsigned int width = source.getWidth();
+    const unsigned int height = source.getHeight();
+    const unsigned int channels = source.getChannels();
+    if (targetWidth == 0 || targetWidth > width) {
+        spdlog::error("applySeamOrder: invalid target width {} for an image of width {}.", targetWidth, width);
+        return ImageData();
+    }
+
+    const unsigned int removedSeams = width - targetWidth;
+    ImageData output(targetWidth, height, channels);
+
+    for (unsigned int y = 0; y < height; ++y) {
+        const unsigned char* in = source.getRow(y);
+        const unsigned int* order = removalOrder + static_cast<size_t>(y) * width;
+        unsigned char* out = output.getRow(y);
+        unsigned char* outEnd = out + static_cast<size_t>(targetWidth) * channels;
+
+        for (unsigned int x = 0; x < width; ++x) {
+            if (order[x] < removedSeams) continue;
+            if (out == outEnd) break;
+            std::memcpy(out, in + static_cast<size_t>(x) * channels, channels);
+            out += channels;
+        }
+        if (out != outEnd) {
+            spdlog::error("applySeamOrder: removal order of row {} does not match the target width.", y);
+            return ImageData();
+        }
     }
 
-    image.setWidth(image.getWidth() - 1);
+    return output;
+}
+
+// One output row of applySeamInsertion. Returns false if the row does not hold exactly
+// (outEnd - out) / channels pixels after insertion.
+template <unsigned int Channels>
+static bool insertSeamRow(const unsigned char* in, const unsigned int* order, unsigned int width, unsigned int insertedSeams,
+                          unsigned char* out, unsigned char* outEnd, unsigned int channels) {
+    const unsigned int c = Channels ? Channels : channels; // 0 = runtime channel count
+    unsigned int x = 0;
+    for (; x < width && out != outEnd; ++x) {
+        const unsigned char* pixel = in + static_cast<size_t>(x) * c;
+        for (unsigned int k = 0; k < c; ++k) out[k] = pixel[k];
+        out += c;
+        if (order[x] >= insertedSeams) continue;
+        if (out == outEnd) return false;
+        // Seam pixel: followed by its average with the right neighbour
+        const unsigned char* right = x + 1 < width ? pixel + c : pixel;
+        for (unsigned int k = 0; k < c; ++k) out[k] = static_cast<unsigned char>((pixel[k] + right[k] + 1) >> 1);
+        out += c;
+    }
+    return x == width && out == outEnd;
 }
 
+ImageData CustomImageFilter::applySeamInsertion(const ImageData& source, const unsigned int* removalOrder, unsigned int targetWidth) {
+    const unsigned int width = source.getWidth();
+    const unsigned int height = source.getHeight();
+    const unsigned int channels = source.getChannels();
+    if (targetWidth < width || targetWidth - width >= width) {
+        spdlog::error("applySeamInsertion: invalid target width {} for an image of width {}.", targetWidth, width);
+        return ImageData();
+    }
+
+    const unsigned int insertedSeams = targetWidth - width;
+    ImageData output(targetWidth, height, channels, source.getLayout());
+    auto insertRow = channels == 3 ? insertSeamRow<3> : channels == 4 ? insertSeamRow<4> : channels == 1 ? insertSeamRow<1> : insertSeamRow<0>;
+
+    for (unsigned int y = 0; y < height; ++y) {
+        unsigned char* out = output.getRow(y);
+        if (!insertRow(source.getRow(y), removalOrder + static_cast<size_t>(y) * width, width, insertedSeams,
+                       out, out + static_cast<size_t>(targetWidth) * channels, channels)) {
+            spdlog::error("applySeamInsertion: removal order of row {} does not match the target width.", y);
+            return ImageData();
+        }
+    }
+
+    return output;
+}
+
+// Square tiles of kTransposeBlock pixels: the source rows and destination rows of one tile
+// (64 x 64 x channels bytes each) stay in L1/L2 while the tile is copied, instead of
+// touching a new cache line for every pixel written down a column.
+static constexpr unsigned int kTransposeBlock = 64;
+
+template <unsigned int Channels>
+static void transposeBlocked(const ImageData& input, ImageData& output, unsigned int channels) {
+    const unsigned int width = input.getWidth();
+    const unsigned int height = input.getHeight();
+    const unsigned int c = Channels ? Channels : channels; // 0 = runtime channel count
+    // Raw pointers: byte stores may alias the ImageData members, accessors would be reloaded per pixel
+    const unsigned char* in = input.getRow(0);
+    unsigned char* out = output.getRow(0);
+    const size_t inPitch = input.getRowPitch();
+    const size_t outPitch = output.getRowPitch();
+
+    for (unsigned int y0 = 0; y0 < height; y0 += kTransposeBlock) {
+        const unsigned int y1 = std::min(height, y0 + kTransposeBlock);
+        for (unsigned int x0 = 0; x0 < width; x0 += kTransposeBlock) {
+            const unsigned int x1 = std::min(width, x0 + kTransposeBlock);
+            for (unsigned int x = x0; x < x1; ++x) {
+                unsigned char* dst = out + x * outPitch + static_cast<size_t>(y0) * c;
+                const unsigned char* src = in + y0 * inPitch + static_cast<size_t>(x) * c;
+                for (unsigned int y = y0; y < y1; ++y) {
+                    for (unsigned int k = 0; k < c; ++k) dst[k] = src[k];
+                    dst += c;
+                    src += inPitch;
+                }
+            }
+        }
+    }
+}
+
+ImageData CustomImageFilter::transpose(const ImageData& input) {
+    ImageData output(input.getHeight(), input.getWidth(), input.getChannels(), input.getLayout());
+    switch (input.getChannels()) {
+        case 1: transposeBlocked<1>(input, output, 1); break;
+        case 3: transposeBlocked<3>(input, output, 3); break;
+        case 4: transposeBlocked<4>(input, output, 4); break;
+        default: transposeBlocked<0>(input, output, input.getChannels()); break;
+    }
+    return output;
+}
+
+// Coefficients of one resampling axis: output i = sum over k < taps of
+// weights[i * taps + k] * input[first[i] + k]. Every output's weights add up to
+// 1 << simd::kResampleBits; windows at the image edges are shifted inside and zero padded.
+struct ResampleCoefficients {
+    unsigned int taps = 0;
+    std::vector<unsigned int> first;
+    std::vector<int16_t> weights;
+};
+
+// Rows handed to one parallelFor index
+static constexpr unsigned int kResampleChunkRows = 32;
+
+static double resampleSupport(ResampleFilter filter) {
+    switch (filter) {
+        case ResampleFilter::Area: return 0.5;
+        case ResampleFilter::Bicubic: return 2.0;
+        default: return 1.0;
+    }
+}
+
+static double resampleKernel(ResampleFilter filter, double x) {
+    x = std::fabs(x);
+    switch (filter) {
+        case ResampleFilter::Area:
+            return x < 0.5 ? 1.0 : 0.0;
+        case ResampleFilter::Bicubic: {
+            constexpr double a = -0.5; // Keys / Catmull-Rom
+            if (x < 1.0) return ((a + 2.0) * x - (a + 3.0)) * x * x + 1.0;
+            if (x < 2.0) return ((a * x - 5.0 * a) * x + 8.0 * a) * x - 4.0 * a;
+            return 0.0;
+        }
+        default:
+            return x < 1.0 ? 1.0 - x : 0.0;
+    }
+}
+
+static ResampleCoefficients resampleCoefficients(unsigned int inSize, unsigned int outSize, ResampleFilter filter) {
+    const double scale = static_cast<double>(inSize) / outSize;
+    const double filterScale = std::max(scale, 1.0);
+    const double support = resampleSupport(filter) * filterScale;
+
+    ResampleCoefficients c;
+    c.taps = std::min(inSize, static_cast<unsigned int>(std::ceil(support)) * 2 + 1);
+    c.first.resize(outSize);
+    c.weights.assign(static_cast<size_t>(outSize) * c.taps, 0);
+    std::vector<double> w(c.taps);
+    for (unsigned int i = 0; i < outSize; ++i) {
+        // Pixel centers at +0.5: output i covers source [i * scale, (i + 1) * scale)
+        const double center = (i + 0.5) * scale;
+        const int xMin = std::max(0, static_cast<int>(std::floor(center - support + 0.5)));
+        const int xMax = std::min(static_cast<int>(inSize), static_cast<int>(std::floor(center + support + 0.5)));
+        const unsigned int count = std::min(static_cast<unsigned int>(std::max(xMax - xMin, 1)), c.taps);
+        const unsigned int first = std::min(static_cast<unsigned int>(xMin), inSize - c.taps);
+        const unsigned int offset = static_cast<unsigned int>(xMin) - first;
+
+        double total = 0.0;
+        for (unsigned int k = 0; k < count; ++k) {
+            w[k] = resampleKernel(filter, (xMin + k - center + 0.5) / filterScale);
+            total += w[k];
+        }
+        int16_t* out = c.weights.data() + static_cast<size_t>(i) * c.taps;
+        if (total == 0.0) { // no source pixel inside the kernel: nearest neighbour
+            out[offset] = 1 << simd::kResampleBits;
+        } else {
+            // Round each weight and give the rounding error to the largest one, so flat
+            // regions stay exactly flat
+            int sum = 0;
+            unsigned int largest = 0;
+            for (unsigned int k = 0; k < count; ++k) {
+                out[offset + k] = static_cast<int16_t>(std::lround(w[k] / total * (1 << simd::kResampleBits)));
+                sum += out[offset + k];
+                if (std::abs(out[offset + k]) > std::abs(out[offset + largest])) largest = k;
+            }
+            out[offset + largest] = static_cast<int16_t>(out[offset + largest] + (1 << simd::kResampleBits) - sum);
+        }
+        c.first[i] = first;
+    }
+    return c;
+}
+
+static inline unsigned char resampleClamp(int sum) {
+    return static_cast<unsigned char>(std::clamp(sum >> simd::kResampleBits, 0, 255));
+}
+
+// Horizontal pass of output pixels [xBegin, outWidth) of one row. Channels = 0 reads the
+// channel count at runtime.
+template <unsigned int Channels>
+static void resampleRow(const unsigned char* in, unsigned char* out, const ResampleCoefficients& c,
+                        unsigned int xBegin, unsigned int outWidth, unsigned int channelCount) {
+    // Locals: stores through 'out' (unsigned char) could alias the coefficient vectors
+    const unsigned int channels = Channels ? Channels : channelCount;
+    const unsigned int taps = c.taps;
+    const unsigned int* first = c.first.data();
+    const int16_t* weights = c.weights.data();
+    for (unsigned int x = xBegin; x < outWidth; ++x) {
+        const unsigned char* src = in + static_cast<size_t>(first[x]) * channels;
+        const int16_t* w = weights + static_cast<size_t>(x) * taps;
+        if constexpr (Channels != 0) {
+            // All channels of a pixel in one sweep over the taps
+            int sum[Channels];
+            for (unsigned int ch = 0; ch < Channels; ++ch) sum[ch] = 1 << (simd::kResampleBits - 1);
+            for (unsigned int k = 0; k < taps; ++k) {
+                for (unsigned int ch = 0; ch < Channels; ++ch) sum[ch] += w[k] * src[k * Channels + ch];
+            }
+            for (unsigned int ch = 0; ch < Channels; ++ch) out[x * Channels + ch] = resampleClamp(sum[ch]);
+        } else {
+            for (unsigned int ch = 0; ch < channels; ++ch) {
+                int sum = 1 << (simd::kResampleBits - 1);
+                for (unsigned int k = 0; k < taps; ++k) sum += w[k] * src[k * channels + ch];
+                out[x * channels + ch] = resampleClamp(sum);
+            }
+        }
+    }
+}
+
+static void resampleRowHorizontal(const unsigned char* in, unsigned int inWidth, unsigned char* out,
+                                  const ResampleCoefficients& c, unsigned int outWidth, unsigned int channels,
+                                  SimdLevel level) {
+    const unsigned int xBegin = simd::resampleRow(level, in, channels, inWidth, c.first.data(), c.weights.data(),
+                                                  c.taps, out, outWidth);
+    switch (channels) {
+        case 1: resampleRow<1>(in, out, c, xBegin, outWidth, 1); break;
+        case 3: resampleRow<3>(in, out, c, xBegin, outWidth, 3); break;
+        case 4: resampleRow<4>(in, out, c, xBegin, outWidth, 4); break;
+        default: resampleRow<0>(in, out, c, xBegin, outWidth, channels); break;
+    }
+}
+
+ImageData CustomImageFilter::resize(const ImageData& input, unsigned int width, unsigned int height, ResampleFilter filter) {
+    return resize(input, width, height, filter, ThreadPool::shared());
+}
+
+// Horizontal pass into an intermediate image (outWidth x input height), then the vertical
+// pass over its rows. An axis that keeps its size skips its pass.
+ImageData CustomImageFilter::resize(const ImageData& input, unsigned int width, unsigned int height,
+                                    ResampleFilter filter, ThreadPool& pool) {
+    const unsigned int inWidth = input.getWidth();
+    const unsigned int inHeight = input.getHeight();
+    const unsigned int channels = input.getChannels();
+    if (width == 0 || height == 0 || inWidth == 0 || inHeight == 0 || channels == 0) {
+        spdlog::error("resize: cannot resize a {}x{} image to {}x{}.", inWidth, inHeight, width, height);
+        return ImageData();
+    }
+    if (width == inWidth && height == inHeight) return input;
+
+    ImageData output(width, height, channels, input.getLayout());
+    const auto forRowChunks = [&pool](unsigned int rows, const std::function<void(unsigned int)>& fn) {
+        pool.parallelFor((rows + kResampleChunkRows - 1) / kResampleChunkRows, [&](unsigned int chunk) {
+            const unsigned int end = std::min(rows, (chunk + 1) * kResampleChunkRows);
+            for (unsigned int y = chunk * kResampleChunkRows; y < end; ++y) fn(y);
+        });
+    };
+
+    const SimdLevel level = getSimdLevel();
+    // Horizontal pass, straight into the output if the height stays
+    ImageData horizontal;
+    const ImageData* columnsSource = &input;
+    if (width != inWidth) {
+        const ResampleCoefficients coefficients = resampleCoefficients(inWidth, width, filter);
+        ImageData* target = &output;
+        if (height != inHeight) {
+            horizontal = ImageData(width, inHeight, channels, input.getLayout());
+            target = &horizontal;
+        }
+        forRowChunks(inHeight, [&](unsigned int y) {
+            resampleRowHorizontal(input.getRow(y), inWidth, target->getRow(y), coefficients, width, channels, level);
+        });
+        if (height == inHeight) return output;
+        columnsSource = &horizontal;
+    }
+
+    // Vertical pass: every output row is a weighted sum of whole source rows
+    const ResampleCoefficients coefficients = resampleCoefficients(inHeight, height, filter);
+    const unsigned int rowBytes = width * channels;
+    // The taps of output row y are the source rows first[y], first[y] + 1, ...
+    std::vector<const unsigned char*> sourceRows(inHeight);
+    for (unsigned int y = 0; y < inHeight; ++y) sourceRows[y] = columnsSource->getRow(y);
+    forRowChunks(height, [&](unsigned int y) {
+        const unsigned char* const* taps = sourceRows.data() + coefficients.first[y];
+        const int16_t* w = coefficients.weights.data() + static_cast<size_t>(y) * coefficients.taps;
+
+        unsigned char* out = output.getRow(y);
+        for (unsigned int i = simd::resampleColumns(level, taps, w, coefficients.taps, out, rowBytes); i < rowBytes; ++i) {
+            int sum = 1 << (simd::kResampleBits - 1);
+            for (unsigned int k = 0; k < coefficients.taps; ++k) sum += w[k] * taps[k][i];
+            out[i] = resampleClamp(sum);
+        }
+    });
+    return output;
+}
 
 void CustomImageFilter::paintSeam(ImageData& image, const std::vector<unsigned int>& seam) {
 
     for(auto pixelIndex : seam) {
-        image.pixels[pixelIndex * image.getChannels()] = 255;     // R
-        image.pixels[pixelIndex * image.getChannels() + 1] = 0;   // G
-        image.pixels[pixelIndex * image.getChannels() + 2] = 0;   // B
+        unsigned char* pixel = image.getRow(pixelIndex / image.getWidth()) + (pixelIndex % image.getWidth()) * image.getChannels();
+        pixel[0] = 255;   // R
+        pixel[1] = 0;     // G
+        pixel[2] = 0;     // B
     }
-
+    image.markModified();
 }
 
 
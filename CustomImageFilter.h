@@ -1,18 +1,120 @@
 #pragma once
+#include <cstdint>
+#include <limits>
 #include "ImageData.h"
 
+class ThreadPool;
+
+// Instruction set used by the vectorized filter kernels
+enum class SimdLevel { Scalar, SSE41, AVX2 };
+
+// How the Sobel gradients are combined into an energy value (both clamped to 255):
+// L2 = sqrt(gx^2 + gy^2) (table lookup, exact), L1 = |gx| + |gy| (cheaper, slightly different seams)
+enum class EnergyNorm { L2, L1 };
+
+// Seam cost model: Backward = sum of the Sobel energy of the removed pixels,
+// Forward = energy of the edges inserted by the removal (better on smooth gradients)
+enum class EnergyMode { Backward, Forward };
+
+// Resampling kernel of CustomImageFilter::resize. Downscaling widens the kernel to the
+// source pixels covered by one output pixel (antialiased), so Area is the box average.
+enum class ResampleFilter { Bilinear, Bicubic, Area };
+
 class CustomImageFilter {
 public:
+    // SIMD dispatch. Defaults to the best level the CPU supports; setSimdLevel clamps
+    // the request to that level. Scalar is the reference implementation.
+    static SimdLevel getSimdLevel();
+    static SimdLevel getSupportedSimdLevel();
+    static void setSimdLevel(SimdLevel level);
+
     // Applies a custom filter to the input image and stores the result in output
     static ImageData sobelX(const ImageData& input);
     static ImageData sobelY(const ImageData& input);
+    // BT.601 luma in fixed point (SIMD for RGB / RGBA). Grey images are copied, grey + alpha
+    // images keep their grey channel. Keeps the row layout of 'input'.
     static ImageData toGreyscale(const ImageData& input);
-    static ImageData sobel(const ImageData& input);
-    static std::vector<unsigned int> computeMinimalEnergyPathMap(ImageData& energyMap);
+    // Same straight from a packed interleaved buffer (e.g. as decoded by stb_image), without
+    // building an ImageData of it first
+    static ImageData toGreyscale(const unsigned char* pixels, unsigned int width, unsigned int height,
+                                 unsigned int channels, RowLayout layout = RowLayout::Packed);
+    static ImageData sobel(const ImageData& input, EnergyNorm norm = EnergyNorm::L2);
+    // Same as above, writing into 'output' (its buffer is reused when the layout matches)
+    static void sobel(const ImageData& input, ImageData& output, EnergyNorm norm = EnergyNorm::L2);
+    // Sobel magnitude of a single pixel (same value as sobel(input, norm) at x, y)
+    static unsigned char sobelAt(const ImageData& input, unsigned int x, unsigned int y, EnergyNorm norm = EnergyNorm::L2);
+    // Cumulative minimal seam energy per pixel (width * height, row-major).
+    // Large maps are computed in parallel on ThreadPool::shared() or the given pool.
+    static std::vector<unsigned int> computeMinimalEnergyPathMap(const ImageData& energyMap);
+    static std::vector<unsigned int> computeMinimalEnergyPathMap(const ImageData& energyMap, ThreadPool& pool);
+    // Same map, also storing per pixel the step (-1, 0, +1) to its cheapest upper neighbour,
+    // so the seam can be traced without reading the map again (see traceSeamColumns)
+    static std::vector<unsigned int> computeMinimalEnergyPathMap(const ImageData& energyMap, std::vector<int8_t>& directions, ThreadPool& pool);
+    // Same DP with a chosen cost type (uint16_t or unsigned int). A seam costs at most
+    // 255 per row, so 16 bit only holds maps up to 257 rows; taller maps log an error.
+    template <typename Cost>
+    static constexpr bool costFits(unsigned int height) {
+        return static_cast<uint64_t>(height) * 255 <= std::numeric_limits<Cost>::max();
+    }
+    template <typename Cost>
+    static std::vector<Cost> computeCostMap(const ImageData& energyMap, ThreadPool& pool);
+    // Minimal seam of an energy map, using the narrowest cost type that fits its height
+    static std::vector<unsigned int> findMinEnergySeam(const ImageData& energyMap);
+    static std::vector<unsigned int> findMinEnergySeam(const ImageData& energyMap, ThreadPool& pool);
+    // Incremental update of a cumulative map after the energy changed in columns
+    // [dirtyBegin[y], dirtyEnd[y]) of every row y: only the cone below the changes whose
+    // values actually differ is recomputed. Returns the number of recomputed cells.
+    static size_t updateMinimalEnergyPathMap(const ImageData& energyMap, std::vector<unsigned int>& minimalEnergyPathMap,
+                                             const std::vector<unsigned int>& dirtyBegin, const std::vector<unsigned int>& dirtyEnd);
+    // Same DP restricted to a band of 'bandWidth' columns per row, starting at bandStart[y]
+    // (clamped to the image), for coarse-to-fine carving. Returns height * bandWidth values;
+    // cells only reachable from outside the band are left at a huge cost.
+    static std::vector<unsigned int> computeMinimalEnergyPathMapInBand(const ImageData& energyMap, const std::vector<unsigned int>& bandStart, unsigned int bandWidth);
+    // Single channel 2x2 max pooling (one pyramid level, odd sizes round up)
+    static ImageData downsampleMax2(const ImageData& energyMap);
+    // Forward energy variant: cumulative cost of the edges a seam creates, computed straight
+    // from the greyscale image (no Sobel pass). Backtrack with identityForwardEnergySeam.
+    static std::vector<unsigned int> computeForwardEnergyPathMap(const ImageData& greyscale);
+    static std::vector<unsigned int> computeForwardEnergyPathMap(const ImageData& greyscale, ThreadPool& pool);
 
     static std::vector<unsigned int> identityMinEnergySeam(const std::vector<unsigned int>& minPathEnergyMap, unsigned int imageWidth, unsigned int imageHeight);
+    template <typename Cost>
+    static std::vector<unsigned int> backtrackCostMap(const std::vector<Cost>& minPathEnergyMap, unsigned int imageWidth, unsigned int imageHeight);
+    // Seam as one column per row (top to bottom), ending at 'lastColumn' of the last row
+    static std::vector<unsigned int> traceSeamColumns(const std::vector<int8_t>& directions, unsigned int imageWidth, unsigned int imageHeight, unsigned int lastColumn);
+    // Same seam as identityMinEnergySeam, as one column per row
+    static std::vector<unsigned int> identityMinEnergySeamColumns(const std::vector<unsigned int>& minPathEnergyMap, const std::vector<int8_t>& directions, unsigned int imageWidth, unsigned int imageHeight);
+    // Backtrack of computeMinimalEnergyPathMapInBand, same seam format as identityMinEnergySeam
+    static std::vector<unsigned int> identityMinEnergySeamInBand(const std::vector<unsigned int>& bandMap, const std::vector<unsigned int>& bandStart, unsigned int bandWidth, unsigned int imageWidth, unsigned int imageHeight);
+    static std::vector<unsigned int> identityForwardEnergySeam(const std::vector<unsigned int>& forwardEnergyPathMap, const ImageData& greyscale);
+    // Up to 'seamCount' pixel-disjoint low energy seams from one map (greedy, cheapest first)
+    static std::vector<std::vector<unsigned int>> identityMinEnergySeams(const std::vector<unsigned int>& minPathEnergyMap, unsigned int imageWidth, unsigned int imageHeight, unsigned int seamCount);
 
+    // Removes one seam (flat pixel indices, one per row) in a single in-place pass
     static void removeSeam(ImageData& image, const std::vector<unsigned int>& seam);
+    // Same for a seam given as one column per row (no index conversion)
+    static void removeSeamColumns(ImageData& image, const std::vector<unsigned int>& columns);
+    // Removes several pixel-disjoint seams (all given in the current image coordinates) in one pass
+    static void removeSeams(ImageData& image, const std::vector<std::vector<unsigned int>>& seams);
+    // Same for a packed per-pixel value map (e.g. source indices); it shrinks to (width - seams) * height
+    static void removeSeams(std::vector<unsigned int>& values, unsigned int width, unsigned int height, const std::vector<std::vector<unsigned int>>& seams);
+
+    // Carve 'source' to 'targetWidth' in one pass from a precomputed seam removal order
+    // (width * height values, see SeamCarver::computeRemovalOrder)
+    static ImageData applySeamOrder(const ImageData& source, const unsigned int* removalOrder, unsigned int targetWidth);
+    // Widen 'source' to 'targetWidth' in one pass: the first (targetWidth - width) seams of the
+    // removal order are duplicated (seam pixel, then its average with the right neighbour).
+    // The order must reach down to 2 * width - targetWidth, so less than width seams per call.
+    static ImageData applySeamInsertion(const ImageData& source, const unsigned int* removalOrder, unsigned int targetWidth);
+    // Swap rows and columns (cache-blocked). Horizontal seams are carved as vertical seams of
+    // the transposed image, so every pass still streams contiguous rows.
+    static ImageData transpose(const ImageData& input);
+    // Separable resize to width x height (fixed point, SIMD vertical pass). Rows are split
+    // over ThreadPool::shared() or the given pool. Keeps the row layout of 'input'.
+    static ImageData resize(const ImageData& input, unsigned int width, unsigned int height,
+                            ResampleFilter filter = ResampleFilter::Bilinear);
+    static ImageData resize(const ImageData& input, unsigned int width, unsigned int height,
+                            ResampleFilter filter, ThreadPool& pool);
     static void paintSeam(ImageData& image, const std::vector<unsigned int>& seam);
 
 };
@@ -0,0 +1,683 @@
+// CustomImageFilterSimd.cpp
+// x86 SSE4.1 / AVX2 versions of the hot CustomImageFilter loops.
+// Notes:
+//   * Kernels are compiled with per-function target attributes, so the rest of the
+//     project keeps the default instruction set and the CPU is checked at runtime.
+//   * Results are bit-exact with the scalar reference implementation.
+//   * On non-x86 targets every kernel reports that nothing was processed.
+#include "CustomImageFilterSimd.h"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define CUSTOM_FILTER_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define SIMD_TARGET(isa)
+#else
+#define SIMD_TARGET(isa) __attribute__((target(isa)))
+#endif
+#endif
+
+namespace simd {
+
+#ifdef CUSTOM_FILTER_X86
+
+SimdLevel detectSimdLevel() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    const int maxLeaf = info[0];
+    __cpuid(info, 1);
+    const bool sse41 = (info[2] & (1 << 19)) != 0;
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    bool avx2 = false;
+    if (maxLeaf >= 7 && osxsave && avx && (_xgetbv(0) & 0x6) == 0x6) {
+        __cpuidex(info, 7, 0);
+        avx2 = (info[1] & (1 << 5)) != 0;
+    }
+#else
+    __builtin_cpu_init();
+    const bool sse41 = __builtin_cpu_supports("sse4.1");
+    const bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+    if (avx2) return SimdLevel::AVX2;
+    if (sse41) return SimdLevel::SSE41;
+    return SimdLevel::Scalar;
+}
+
+// ---------------------------------------------------------------------------
+// SSE4.1: 8 pixels per half, 16 pixels per iteration (16 bit lanes)
+// ---------------------------------------------------------------------------
+
+SIMD_TARGET("sse4.1")
+static inline __m128i load8x16(const unsigned char* p) {
+    return _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)));
+}
+
+// |gradient| clamped to [0, 255] for 8 pixels starting at column x
+SIMD_TARGET("sse4.1")
+static inline void sobelGradients8(const unsigned char* up, const unsigned char* mid, const unsigned char* down,
+                                   unsigned int x, __m128i& gx, __m128i& gy) {
+    const __m128i upL = load8x16(up + x - 1), upC = load8x16(up + x), upR = load8x16(up + x + 1);
+    const __m128i midL = load8x16(mid + x - 1), midR = load8x16(mid + x + 1);
+    const __m128i downL = load8x16(down + x - 1), downC = load8x16(down + x), downR = load8x16(down + x + 1);
+
+    const __m128i dxMid = _mm_sub_epi16(midR, midL);
+    gx = _mm_add_epi16(_mm_add_epi16(_mm_sub_epi16(upR, upL), _mm_sub_epi16(downR, downL)), _mm_add_epi16(dxMid, dxMid));
+    const __m128i sumUp = _mm_add_epi16(_mm_add_epi16(upL, upR), _mm_add_epi16(upC, upC));
+    const __m128i sumDown = _mm_add_epi16(_mm_add_epi16(downL, downR), _mm_add_epi16(downC, downC));
+    gy = _mm_sub_epi16(sumDown, sumUp);
+
+    const __m128i max255 = _mm_set1_epi16(255);
+    gx = _mm_min_epi16(_mm_abs_epi16(gx), max255);
+    gy = _mm_min_epi16(_mm_abs_epi16(gy), max255);
+}
+
+// floor(sqrt(gx^2 + gy^2)) clamped to 255. Single precision is exact here: the sum is
+// at most 2*255^2, so the square root never rounds up to the next integer.
+SIMD_TARGET("sse4.1")
+static inline __m128i magnitude8(__m128i gx, __m128i gy) {
+    const __m128i lo = _mm_unpacklo_epi16(gx, gy);
+    const __m128i hi = _mm_unpackhi_epi16(gx, gy);
+    const __m128i sqLo = _mm_madd_epi16(lo, lo);
+    const __m128i sqHi = _mm_madd_epi16(hi, hi);
+    const __m128i magLo = _mm_cvttps_epi32(_mm_sqrt_ps(_mm_cvtepi32_ps(sqLo)));
+    const __m128i magHi = _mm_cvttps_epi32(_mm_sqrt_ps(_mm_cvtepi32_ps(sqHi)));
+    return _mm_min_epi16(_mm_packs_epi32(magLo, magHi), _mm_set1_epi16(255));
+}
+
+template <SobelOutput What>
+SIMD_TARGET("sse4.1")
+static unsigned int sobelRowSse41(const unsigned char* up, const unsigned char* mid, const unsigned char* down,
+                                  unsigned char* out, unsigned int width) {
+    unsigned int x = 1;
+    // Loads reach column x + 16, which must stay inside the row
+    for (; x + 16 < width; x += 16) {
+        __m128i result[2];
+        for (int half = 0; half < 2; ++half) {
+            __m128i gx, gy;
+            sobelGradients8(up, mid, down, x + half * 8, gx, gy);
+            if (What == SobelOutput::GradX) result[half] = gx;
+            else if (What == SobelOutput::GradY) result[half] = gy;
+            else if (What == SobelOutput::MagnitudeL1) result[half] = _mm_min_epi16(_mm_add_epi16(gx, gy), _mm_set1_epi16(255));
+            else result[half] = magnitude8(gx, gy);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), _mm_packus_epi16(result[0], result[1]));
+    }
+    return x;
+}
+
+// ---------------------------------------------------------------------------
+// AVX2: 16 pixels per half, 32 pixels per iteration (16 bit lanes)
+// ---------------------------------------------------------------------------
+
+SIMD_TARGET("avx2")
+static inline __m256i load16x16(const unsigned char* p) {
+    return _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+}
+
+SIMD_TARGET("avx2")
+static inline void sobelGradients16(const unsigned char* up, const unsigned char* mid, const unsigned char* down,
+                                    unsigned int x, __m256i& gx, __m256i& gy) {
+    const __m256i upL = load16x16(up + x - 1), upC = load16x16(up + x), upR = load16x16(up + x + 1);
+    const __m256i midL = load16x16(mid + x - 1), midR = load16x16(mid + x + 1);
+    const __m256i downL = load16x16(down + x - 1), downC = load16x16(down + x), downR = load16x16(down + x + 1);
+
+    const __m256i dxMid = _mm256_sub_epi16(midR, midL);
+    gx = _mm256_add_epi16(_mm256_add_epi16(_mm256_sub_epi16(upR, upL), _mm256_sub_epi16(downR, downL)),
+                          _mm256_add_epi16(dxMid, dxMid));
+    const __m256i sumUp = _mm256_add_epi16(_mm256_add_epi16(upL, upR), _mm256_add_epi16(upC, upC));
+    const __m256i sumDown = _mm256_add_epi16(_mm256_add_epi16(downL, downR), _mm256_add_epi16(downC, downC));
+    gy = _mm256_sub_epi16(sumDown, sumUp);
+
+    const __m256i max255 = _mm256_set1_epi16(255);
+    gx = _mm256_min_epi16(_mm256_abs_epi16(gx), max255);
+    gy = _mm256_min_epi16(_mm256_abs_epi16(gy), max255);
+}
+
+// Unpack / pack work per 128 bit lane, so the pixel order survives the round trip.
+SIMD_TARGET("avx2")
+static inline __m256i magnitude16(__m256i gx, __m256i gy) {
+    const __m256i lo = _mm256_unpacklo_epi16(gx, gy);
+    const __m256i hi = _mm256_unpackhi_epi16(gx, gy);
+    const __m256i sqLo = _mm256_madd_epi16(lo, lo);
+    const __m256i sqHi = _mm256_madd_epi16(hi, hi);
+    const __m256i magLo = _mm256_cvttps_epi32(_mm256_sqrt_ps(_mm256_cvtepi32_ps(sqLo)));
+    const __m256i magHi = _mm256_cvttps_epi32(_mm256_sqrt_ps(_mm256_cvtepi32_ps(sqHi)));
+    return _mm256_min_epi16(_mm256_packs_epi32(magLo, magHi), _mm256_set1_epi16(255));
+}
+
+template <SobelOutput What>
+SIMD_TARGET("avx2")
+static unsigned int sobelRowAvx2(const unsigned char* up, const unsigned char* mid, const unsigned char* down,
+                                 unsigned char* out, unsigned int width) {
+    unsigned int x = 1;
+    // Loads reach column x + 32, which must stay inside the row
+    for (; x + 32 < width; x += 32) {
+        __m256i result[2];
+        for (int half = 0; half < 2; ++half) {
+            __m256i gx, gy;
+            sobelGradients16(up, mid, down, x + half * 16, gx, gy);
+            if (What == SobelOutput::GradX) result[half] = gx;
+            else if (What == SobelOutput::GradY) result[half] = gy;
+            else if (What == SobelOutput::MagnitudeL1) result[half] = _mm256_min_epi16(_mm256_add_epi16(gx, gy), _mm256_set1_epi16(255));
+            else result[half] = magnitude16(gx, gy);
+        }
+        // packus interleaves the two 128 bit lanes, restore pixel order afterwards
+        const __m256i packed = _mm256_packus_epi16(result[0], result[1]);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + x), _mm256_permute4x64_epi64(packed, 0xD8));
+    }
+    return x;
+}
+
+template <SobelOutput What>
+static unsigned int sobelRowDispatch(SimdLevel level, const unsigned char* up, const unsigned char* mid,
+                                     const unsigned char* down, unsigned char* out, unsigned int width) {
+    switch (level) {
+        case SimdLevel::AVX2: return sobelRowAvx2<What>(up, mid, down, out, width);
+        case SimdLevel::SSE41: return sobelRowSse41<What>(up, mid, down, out, width);
+        default: return 1;
+    }
+}
+
+unsigned int sobelRow(SimdLevel level, SobelOutput what, const unsigned char* up, const unsigned char* mid,
+                      const unsigned char* down, unsigned char* out, unsigned int width) {
+    switch (what) {
+        case SobelOutput::GradX: return sobelRowDispatch<SobelOutput::GradX>(level, up, mid, down, out, width);
+        case SobelOutput::GradY: return sobelRowDispatch<SobelOutput::GradY>(level, up, mid, down, out, width);
+        case SobelOutput::MagnitudeL1: return sobelRowDispatch<SobelOutput::MagnitudeL1>(level, up, mid, down, out, width);
+        default: return sobelRowDispatch<SobelOutput::Magnitude>(level, up, mid, down, out, width);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Minimal energy path map row: min of three neighbours (unsigned 32 bit lanes)
+// ---------------------------------------------------------------------------
+
+SIMD_TARGET("sse4.1")
+static unsigned int minimalEnergyRowSse41(const unsigned int* prev, const unsigned char* energy,
+                                          unsigned int* out, unsigned int xBegin, unsigned int xEnd) {
+    unsigned int x = xBegin;
+    for (; x + 4 <= xEnd; x += 4) {
+        const __m128i left = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev + x - 1));
+        const __m128i above = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev + x));
+        const __m128i right = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev + x + 1));
+        int energy4;
+        std::memcpy(&energy4, energy + x, sizeof(energy4));
+        const __m128i e = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(energy4));
+        const __m128i minimum = _mm_min_epu32(_mm_min_epu32(left, above), right);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), _mm_add_epi32(minimum, e));
+    }
+    return x;
+}
+
+SIMD_TARGET("avx2")
+static unsigned int minimalEnergyRowAvx2(const unsigned int* prev, const unsigned char* energy,
+                                         unsigned int* out, unsigned int xBegin, unsigned int xEnd) {
+    unsigned int x = xBegin;
+    for (; x + 8 <= xEnd; x += 8) {
+        const __m256i left = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(prev + x - 1));
+        const __m256i above = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(prev + x));
+        const __m256i right = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(prev + x + 1));
+        const __m256i e = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(energy + x)));
+        const __m256i minimum = _mm256_min_epu32(_mm256_min_epu32(left, above), right);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + x), _mm256_add_epi32(minimum, e));
+    }
+    return x;
+}
+
+unsigned int minimalEnergyRow(SimdLevel level, const unsigned int* prev, const unsigned char* energy,
+                              unsigned int* out, unsigned int xBegin, unsigned int xEnd) {
+    switch (level) {
+        case SimdLevel::AVX2: return minimalEnergyRowAvx2(prev, energy, out, xBegin, xEnd);
+        case SimdLevel::SSE41: return minimalEnergyRowSse41(prev, energy, out, xBegin, xEnd);
+        default: return xBegin;
+    }
+}
+
+// Same row, also storing the step to the cheapest upper neighbour (-1, 0, +1) with the
+// backtrack's preference: above, then strictly cheaper left, then strictly cheaper right.
+// Costs stay far below 2^31, so the signed compares are exact.
+SIMD_TARGET("sse4.1")
+static unsigned int minimalEnergyRowSse41(const unsigned int* prev, const unsigned char* energy,
+                                          unsigned int* out, int8_t* directions, unsigned int xBegin, unsigned int xEnd) {
+    const __m128i zero = _mm_setzero_si128();
+    unsigned int x = xBegin;
+    for (; x + 4 <= xEnd; x += 4) {
+        const __m128i left = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev + x - 1));
+        const __m128i above = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev + x));
+        const __m128i right = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev + x + 1));
+        int energy4;
+        std::memcpy(&energy4, energy + x, sizeof(energy4));
+        const __m128i e = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(energy4));
+        const __m128i leftCheaper = _mm_cmpgt_epi32(above, left);
+        const __m128i upper = _mm_min_epu32(left, above);
+        const __m128i rightCheaper = _mm_cmpgt_epi32(upper, right);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), _mm_add_epi32(_mm_min_epu32(upper, right), e));
+        // -1 where left wins, +1 where right wins, narrowed to bytes
+        const __m128i step = _mm_blendv_epi8(leftCheaper, _mm_sub_epi32(zero, rightCheaper), rightCheaper);
+        const __m128i packed = _mm_packs_epi16(_mm_packs_epi32(step, step), zero);
+        const int steps4 = _mm_cvtsi128_si32(packed);
+        std::memcpy(directions + x, &steps4, sizeof(steps4));
+    }
+    return x;
+}
+
+SIMD_TARGET("avx2")
+static unsigned int minimalEnergyRowAvx2(const unsigned int* prev, const unsigned char* energy,
+                                         unsigned int* out, int8_t* directions, unsigned int xBegin, unsigned int xEnd) {
+    const __m256i zero = _mm256_setzero_si256();
+    unsigned int x = xBegin;
+    for (; x + 8 <= xEnd; x += 8) {
+        const __m256i left = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(prev + x - 1));
+        const __m256i above = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(prev + x));
+        const __m256i right = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(prev + x + 1));
+        const __m256i e = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(energy + x)));
+        const __m256i leftCheaper = _mm256_cmpgt_epi32(above, left);
+        const __m256i upper = _mm256_min_epu32(left, above);
+        const __m256i rightCheaper = _mm256_cmpgt_epi32(upper, right);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + x), _mm256_add_epi32(_mm256_min_epu32(upper, right), e));
+        // Packing stays within 128 bit lanes: bytes 0-3 of each lane hold 4 steps
+        const __m256i step = _mm256_blendv_epi8(leftCheaper, _mm256_sub_epi32(zero, rightCheaper), rightCheaper);
+        const __m256i packed = _mm256_packs_epi16(_mm256_packs_epi32(step, step), zero);
+        const int steps0 = _mm_cvtsi128_si32(_mm256_castsi256_si128(packed));
+        const int steps1 = _mm_cvtsi128_si32(_mm256_extracti128_si256(packed, 1));
+        std::memcpy(directions + x, &steps0, sizeof(steps0));
+        std::memcpy(directions + x + 4, &steps1, sizeof(steps1));
+    }
+    return x;
+}
+
+unsigned int minimalEnergyRow(SimdLevel level, const unsigned int* prev, const unsigned char* energy,
+                              unsigned int* out, int8_t* directions, unsigned int xBegin, unsigned int xEnd) {
+    switch (level) {
+        case SimdLevel::AVX2: return minimalEnergyRowAvx2(prev, energy, out, directions, xBegin, xEnd);
+        case SimdLevel::SSE41: return minimalEnergyRowSse41(prev, energy, out, directions, xBegin, xEnd);
+        default: return xBegin;
+    }
+}
+
+// 16 bit costs (heights up to 257): twice the lanes per register
+SIMD_TARGET("sse4.1")
+static unsigned int minimalEnergyRow16Sse41(const uint16_t* prev, const unsigned char* energy,
+                                            uint16_t* out, unsigned int xBegin, unsigned int xEnd) {
+    unsigned int x = xBegin;
+    for (; x + 8 <= xEnd; x += 8) {
+        const __m128i left = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev + x - 1));
+        const __m128i above = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev + x));
+        const __m128i right = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev + x + 1));
+        const __m128i e = _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(energy + x)));
+        const __m128i minimum = _mm_min_epu16(_mm_min_epu16(left, above), right);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), _mm_add_epi16(minimum, e));
+    }
+    return x;
+}
+
+SIMD_TARGET("avx2")
+static unsigned int minimalEnergyRow16Avx2(const uint16_t* prev, const unsigned char* energy,
+                                           uint16_t* out, unsigned int xBegin, unsigned int xEnd) {
+    unsigned int x = xBegin;
+    for (; x + 16 <= xEnd; x += 16) {
+        const __m256i left = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(prev + x - 1));
+        const __m256i above = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(prev + x));
+        const __m256i right = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(prev + x + 1));
+        const __m256i e = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(energy + x)));
+        const __m256i minimum = _mm256_min_epu16(_mm256_min_epu16(left, above), right);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + x), _mm256_add_epi16(minimum, e));
+    }
+    return x;
+}
+
+unsigned int minimalEnergyRow(SimdLevel level, const uint16_t* prev, const unsigned char* energy,
+                              uint16_t* out, unsigned int xBegin, unsigned int xEnd) {
+    switch (level) {
+        case SimdLevel::AVX2: return minimalEnergyRow16Avx2(prev, energy, out, xBegin, xEnd);
+        case SimdLevel::SSE41: return minimalEnergyRow16Sse41(prev, energy, out, xBegin, xEnd);
+        default: return xBegin;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Forward energy cumulative cost
+// ---------------------------------------------------------------------------
+
+SIMD_TARGET("sse4.1")
+static inline __m128i load4x32(const unsigned char* p) {
+    int v;
+    std::memcpy(&v, p, sizeof(v));
+    return _mm_cvtepu8_epi32(_mm_cvtsi32_si128(v));
+}
+
+SIMD_TARGET("avx2")
+static inline __m256i load8x32(const unsigned char* p) {
+    return _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)));
+}
+
+SIMD_TARGET("sse4.1")
+static unsigned int forwardEnergyRowSse41(const unsigned int* prev, const unsigned char* up, const unsigned char* mid,
+                                          unsigned int* out, unsigned int xBegin, unsigned int xEnd) {
+    unsigned int x = xBegin;
+    for (; x + 4 <= xEnd; x += 4) {
+        const __m128i l = load4x32(mid + x - 1);
+        const __m128i r = load4x32(mid + x + 1);
+        const __m128i u = load4x32(up + x);
+        const __m128i cU = _mm_abs_epi32(_mm_sub_epi32(r, l));
+        const __m128i left = _mm_add_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(prev + x - 1)), _mm_abs_epi32(_mm_sub_epi32(u, l)));
+        const __m128i above = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev + x));
+        const __m128i right = _mm_add_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(prev + x + 1)), _mm_abs_epi32(_mm_sub_epi32(u, r)));
+        const __m128i minimum = _mm_min_epu32(_mm_min_epu32(left, above), right);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), _mm_add_epi32(minimum, cU));
+    }
+    return x;
+}
+
+SIMD_TARGET("avx2")
+static unsigned int forwardEnergyRowAvx2(const unsigned int* prev, const unsigned char* up, const unsigned char* mid,
+                                         unsigned int* out, unsigned int xBegin, unsigned int xEnd) {
+    unsigned int x = xBegin;
+    for (; x + 8 <= xEnd; x += 8) {
+        const __m256i l = load8x32(mid + x - 1);
+        const __m256i r = load8x32(mid + x + 1);
+        const __m256i u = load8x32(up + x);
+        const __m256i cU = _mm256_abs_epi32(_mm256_sub_epi32(r, l));
+        const __m256i left = _mm256_add_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(prev + x - 1)), _mm256_abs_epi32(_mm256_sub_epi32(u, l)));
+        const __m256i above = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(prev + x));
+        const __m256i right = _mm256_add_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(prev + x + 1)), _mm256_abs_epi32(_mm256_sub_epi32(u, r)));
+        const __m256i minimum = _mm256_min_epu32(_mm256_min_epu32(left, above), right);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + x), _mm256_add_epi32(minimum, cU));
+    }
+    return x;
+}
+
+unsigned int forwardEnergyRow(SimdLevel level, const unsigned int* prev, const unsigned char* up, const unsigned char* mid,
+                              unsigned int* out, unsigned int xBegin, unsigned int xEnd) {
+    switch (level) {
+        case SimdLevel::AVX2: return forwardEnergyRowAvx2(prev, up, mid, out, xBegin, xEnd);
+        case SimdLevel::SSE41: return forwardEnergyRowSse41(prev, up, mid, out, xBegin, xEnd);
+        default: return xBegin;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// 2x2 max pooling row: vertical max, then max of the byte pairs (16 bit lanes)
+// ---------------------------------------------------------------------------
+
+SIMD_TARGET("sse4.1")
+static inline __m128i pairMax16(const unsigned char* row0, const unsigned char* row1) {
+    const __m128i m = _mm_max_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row0)),
+                                   _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1)));
+    return _mm_and_si128(_mm_max_epu8(m, _mm_srli_epi16(m, 8)), _mm_set1_epi16(0x00ff));
+}
+
+SIMD_TARGET("sse4.1")
+static unsigned int downsampleMax2RowSse41(const unsigned char* row0, const unsigned char* row1,
+                                           unsigned char* out, unsigned int outEnd) {
+    unsigned int x = 0;
+    for (; x + 16 <= outEnd; x += 16) {
+        const __m128i lo = pairMax16(row0 + 2 * x, row1 + 2 * x);
+        const __m128i hi = pairMax16(row0 + 2 * x + 16, row1 + 2 * x + 16);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), _mm_packus_epi16(lo, hi));
+    }
+    return x;
+}
+
+SIMD_TARGET("avx2")
+static inline __m256i pairMax32(const unsigned char* row0, const unsigned char* row1) {
+    const __m256i m = _mm256_max_epu8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(row0)),
+                                      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row1)));
+    return _mm256_and_si256(_mm256_max_epu8(m, _mm256_srli_epi16(m, 8)), _mm256_set1_epi16(0x00ff));
+}
+
+SIMD_TARGET("avx2")
+static unsigned int downsampleMax2RowAvx2(const unsigned char* row0, const unsigned char* row1,
+                                          unsigned char* out, unsigned int outEnd) {
+    unsigned int x = 0;
+    for (; x + 32 <= outEnd; x += 32) {
+        const __m256i lo = pairMax32(row0 + 2 * x, row1 + 2 * x);
+        const __m256i hi = pairMax32(row0 + 2 * x + 32, row1 + 2 * x + 32);
+        // packus works per 128 bit lane: restore the column order
+        const __m256i packed = _mm256_packus_epi16(lo, hi);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + x), _mm256_permute4x64_epi64(packed, 0xD8));
+    }
+    return x;
+}
+
+unsigned int downsampleMax2Row(SimdLevel level, const unsigned char* row0, const unsigned char* row1,
+                               unsigned char* out, unsigned int outEnd) {
+    switch (level) {
+        case SimdLevel::AVX2: return downsampleMax2RowAvx2(row0, row1, out, outEnd);
+        case SimdLevel::SSE41: return downsampleMax2RowSse41(row0, row1, out, outEnd);
+        default: return 0;
+    }
+}
+
+// Pixels are expanded to 16 bit RGBx, madd gives r*R + g*G and b*B per pixel, hadd sums those.
+// RGB is first shuffled to RGBx; its 16 byte loads cover 4 pixels plus 4 bytes of the next.
+static constexpr unsigned int lumaOverread(unsigned int channels) { return channels == 3 ? 2 : 0; }
+
+template <unsigned int Channels>
+SIMD_TARGET("sse4.1")
+static inline __m128i lumaQuad(const unsigned char* in) {
+    __m128i rgbx = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+    if (Channels == 3) {
+        rgbx = _mm_shuffle_epi8(rgbx, _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1));
+    }
+    const __m128i weights = _mm_setr_epi16(kLumaR, kLumaG, kLumaB, 0, kLumaR, kLumaG, kLumaB, 0);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi8(rgbx, zero), weights);
+    const __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi8(rgbx, zero), weights);
+    return _mm_srli_epi32(_mm_add_epi32(_mm_hadd_epi32(lo, hi), _mm_set1_epi32(kLumaRound)), kLumaShift);
+}
+
+template <unsigned int Channels>
+SIMD_TARGET("sse4.1")
+static unsigned int lumaRowSse41(const unsigned char* in, unsigned char* out, unsigned int width) {
+    unsigned int x = 0;
+    for (; x + 16 + lumaOverread(Channels) <= width; x += 16) {
+        const unsigned char* px = in + x * Channels;
+        const __m128i lo = _mm_packus_epi32(lumaQuad<Channels>(px), lumaQuad<Channels>(px + 4 * Channels));
+        const __m128i hi = _mm_packus_epi32(lumaQuad<Channels>(px + 8 * Channels), lumaQuad<Channels>(px + 12 * Channels));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), _mm_packus_epi16(lo, hi));
+    }
+    return x;
+}
+
+// 8 pixels, lanes hold pixels 0-3 and 4-7
+template <unsigned int Channels>
+SIMD_TARGET("avx2")
+static inline __m256i lumaOct(const unsigned char* in) {
+    __m256i rgbx;
+    if (Channels == 3) {
+        rgbx = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in))),
+                                       _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 12)), 1);
+        rgbx = _mm256_shuffle_epi8(rgbx, _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+                                                          0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1));
+    } else {
+        rgbx = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in));
+    }
+    const __m256i weights = _mm256_setr_epi16(kLumaR, kLumaG, kLumaB, 0, kLumaR, kLumaG, kLumaB, 0,
+                                              kLumaR, kLumaG, kLumaB, 0, kLumaR, kLumaG, kLumaB, 0);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i lo = _mm256_madd_epi16(_mm256_unpacklo_epi8(rgbx, zero), weights);
+    const __m256i hi = _mm256_madd_epi16(_mm256_unpackhi_epi8(rgbx, zero), weights);
+    return _mm256_srli_epi32(_mm256_add_epi32(_mm256_hadd_epi32(lo, hi), _mm256_set1_epi32(kLumaRound)), kLumaShift);
+}
+
+template <unsigned int Channels>
+SIMD_TARGET("avx2")
+static unsigned int lumaRowAvx2(const unsigned char* in, unsigned char* out, unsigned int width) {
+    unsigned int x = 0;
+    for (; x + 32 + lumaOverread(Channels) <= width; x += 32) {
+        const unsigned char* px = in + x * Channels;
+        const __m256i lo = _mm256_packus_epi32(lumaOct<Channels>(px), lumaOct<Channels>(px + 8 * Channels));
+        const __m256i hi = _mm256_packus_epi32(lumaOct<Channels>(px + 16 * Channels), lumaOct<Channels>(px + 24 * Channels));
+        // The packs work per 128 bit lane: restore the order of the 4 pixel groups
+        const __m256i packed = _mm256_packus_epi16(lo, hi);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + x),
+                            _mm256_permutevar8x32_epi32(packed, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7)));
+    }
+    return x;
+}
+
+unsigned int lumaRow(SimdLevel level, const unsigned char* in, unsigned int channels,
+                     unsigned char* out, unsigned int width) {
+    if (channels != 3 && channels != 4) return 0;
+    switch (level) {
+        case SimdLevel::AVX2: return channels == 3 ? lumaRowAvx2<3>(in, out, width) : lumaRowAvx2<4>(in, out, width);
+        case SimdLevel::SSE41: return channels == 3 ? lumaRowSse41<3>(in, out, width) : lumaRowSse41<4>(in, out, width);
+        default: return 0;
+    }
+}
+
+// Two taps per madd: the bytes of rows k and k + 1 are widened and interleaved, so each
+// 32 bit lane gets rows[k][i] * weights[k] + rows[k + 1][i] * weights[k + 1]. An odd last
+// tap is paired with itself at weight 0.
+static inline int weightPair(const int16_t* weights, unsigned int k, unsigned int taps) {
+    const uint16_t second = k + 1 < taps ? static_cast<uint16_t>(weights[k + 1]) : 0;
+    return static_cast<int>((static_cast<uint32_t>(second) << 16) | static_cast<uint16_t>(weights[k]));
+}
+
+SIMD_TARGET("sse4.1")
+static unsigned int resampleColumnsSse41(const unsigned char* const* rows, const int16_t* weights,
+                                         unsigned int taps, unsigned char* out, unsigned int count) {
+    const __m128i round = _mm_set1_epi32(1 << (kResampleBits - 1));
+    unsigned int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i lo = round;
+        __m128i hi = round;
+        for (unsigned int k = 0; k < taps; k += 2) {
+            const unsigned char* second = k + 1 < taps ? rows[k + 1] : rows[k];
+            const __m128i a = _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(rows[k] + i)));
+            const __m128i b = _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(second + i)));
+            const __m128i w = _mm_set1_epi32(weightPair(weights, k, taps));
+            lo = _mm_add_epi32(lo, _mm_madd_epi16(_mm_unpacklo_epi16(a, b), w));
+            hi = _mm_add_epi32(hi, _mm_madd_epi16(_mm_unpackhi_epi16(a, b), w));
+        }
+        const __m128i packed = _mm_packs_epi32(_mm_srai_epi32(lo, kResampleBits), _mm_srai_epi32(hi, kResampleBits));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(packed, packed));
+    }
+    return i;
+}
+
+SIMD_TARGET("avx2")
+static unsigned int resampleColumnsAvx2(const unsigned char* const* rows, const int16_t* weights,
+                                        unsigned int taps, unsigned char* out, unsigned int count) {
+    const __m256i round = _mm256_set1_epi32(1 << (kResampleBits - 1));
+    unsigned int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256i lo = round; // bytes 0-3 | 8-11
+        __m256i hi = round; // bytes 4-7 | 12-15
+        for (unsigned int k = 0; k < taps; k += 2) {
+            const unsigned char* second = k + 1 < taps ? rows[k + 1] : rows[k];
+            const __m256i a = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[k] + i)));
+            const __m256i b = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(second + i)));
+            const __m256i w = _mm256_set1_epi32(weightPair(weights, k, taps));
+            lo = _mm256_add_epi32(lo, _mm256_madd_epi16(_mm256_unpacklo_epi16(a, b), w));
+            hi = _mm256_add_epi32(hi, _mm256_madd_epi16(_mm256_unpackhi_epi16(a, b), w));
+        }
+        // packs per lane puts the bytes back in order: 0-7 | 8-15
+        const __m256i packed = _mm256_packs_epi32(_mm256_srai_epi32(lo, kResampleBits), _mm256_srai_epi32(hi, kResampleBits));
+        const __m256i bytes = _mm256_permute4x64_epi64(_mm256_packus_epi16(packed, packed), 0x08);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm256_castsi256_si128(bytes));
+    }
+    return i;
+}
+
+// One output pixel per step, channels in 32 bit lanes: two neighbouring source pixels are
+// shuffled to (c0 of k, c0 of k + 1, c1 of k, c1 of k + 1, ...) in 16 bit, so one madd with
+// the weight pair adds both taps to every channel. Loads are 8 bytes from pixel k.
+template <unsigned int Channels>
+SIMD_TARGET("sse4.1")
+static unsigned int resampleRowSse41(const unsigned char* in, unsigned int inWidth, const unsigned int* first,
+                                     const int16_t* weights, unsigned int taps, unsigned char* out, unsigned int outWidth) {
+    const __m128i pairs = Channels == 3 ? _mm_setr_epi8(0, -1, 3, -1, 1, -1, 4, -1, 2, -1, 5, -1, -1, -1, -1, -1)
+                                        : _mm_setr_epi8(0, -1, 4, -1, 1, -1, 5, -1, 2, -1, 6, -1, 3, -1, 7, -1);
+    const __m128i round = _mm_set1_epi32(1 << (kResampleBits - 1));
+    const size_t rowBytes = static_cast<size_t>(inWidth) * Channels;
+    const unsigned int xEnd = Channels == 3 && outWidth > 0 ? outWidth - 1 : outWidth;
+    unsigned int x = 0;
+    for (; x < xEnd; ++x) {
+        if ((static_cast<size_t>(first[x]) + taps) * Channels + 8 > rowBytes) break;
+        const unsigned char* src = in + static_cast<size_t>(first[x]) * Channels;
+        const int16_t* w = weights + static_cast<size_t>(x) * taps;
+        __m128i sum = round;
+        for (unsigned int k = 0; k < taps; k += 2) {
+            const __m128i px = _mm_shuffle_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + k * Channels)), pairs);
+            sum = _mm_add_epi32(sum, _mm_madd_epi16(px, _mm_set1_epi32(weightPair(w, k, taps))));
+        }
+        const __m128i packed = _mm_packs_epi32(_mm_srai_epi32(sum, kResampleBits), _mm_setzero_si128());
+        const int bytes = _mm_cvtsi128_si32(_mm_packus_epi16(packed, packed));
+        std::memcpy(out + static_cast<size_t>(x) * Channels, &bytes, 4); // RGB: the 4th byte is rewritten by pixel x + 1
+    }
+    return x;
+}
+
+unsigned int resampleRow(SimdLevel level, const unsigned char* in, unsigned int channels, unsigned int inWidth,
+                         const unsigned int* first, const int16_t* weights, unsigned int taps,
+                         unsigned char* out, unsigned int outWidth) {
+    if (level == SimdLevel::Scalar || (channels != 3 && channels != 4)) return 0;
+    // AVX2 has nothing to add for 4 lanes of 32 bit per pixel
+    return channels == 3 ? resampleRowSse41<3>(in, inWidth, first, weights, taps, out, outWidth)
+                         : resampleRowSse41<4>(in, inWidth, first, weights, taps, out, outWidth);
+}
+
+unsigned int resampleColumns(SimdLevel level, const unsigned char* const* rows, const int16_t* weights,
+                             unsigned int taps, unsigned char* out, unsigned int count) {
+    switch (level) {
+        case SimdLevel::AVX2: return resampleColumnsAvx2(rows, weights, taps, out, count);
+        case SimdLevel::SSE41: return resampleColumnsSse41(rows, weights, taps, out, count);
+        default: return 0;
+    }
+}
+
+#else // !CUSTOM_FILTER_X86
+
+SimdLevel detectSimdLevel() { return SimdLevel::Scalar; }
+
+unsigned int sobelRow(SimdLevel, SobelOutput, const unsigned char*, const unsigned char*,
+                      const unsigned char*, unsigned char*, unsigned int) {
+    return 1;
+}
+
+unsigned int minimalEnergyRow(SimdLevel, const unsigned int*, const unsigned char*, unsigned int*,
+                              unsigned int xBegin, unsigned int) {
+    return xBegin;
+}
+
+unsigned int minimalEnergyRow(SimdLevel, const uint16_t*, const unsigned char*, uint16_t*,
+                              unsigned int xBegin, unsigned int) {
+    return xBegin;
+}
+
+unsigned int minimalEnergyRow(SimdLevel, const unsigned int*, const unsigned char*, unsigned int*, int8_t*,
+                              unsigned int xBegin, unsigned int) {
+    return xBegin;
+}
+
+unsigned int forwardEnergyRow(SimdLevel, const unsigned int*, const unsigned char*, const unsigned char*,
+                              unsigned int*, unsigned int xBegin, unsigned int) {
+    return xBegin;
+}
+
+unsigned int downsampleMax2Row(SimdLevel, const unsigned char*, const unsigned char*, unsigned char*, unsigned int) {
+    return 0;
+}
+
+unsigned int lumaRow(SimdLevel, const unsigned char*, unsigned int, unsigned char*, unsigned int) {
+    return 0;
+}
+
+unsigned int resampleColumns(SimdLevel, const unsigned char* const*, const int16_t*, unsigned int, unsigned char*, unsigned int) {
+    return 0;
+}
+
+unsigned int resampleRow(SimdLevel, const unsigned char*, unsigned int, unsigned int, const unsigned int*, const int16_t*,
+                         unsigned int, unsigned char*, unsigned int) {
+    return 0;
+}
+
+#endif
+
+} // namespace simd
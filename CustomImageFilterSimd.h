@@ -0,0 +1,79 @@
+#pragma once
+// Internal SIMD kernels used by CustomImageFilter. Each kernel processes the interior
+// of a row and returns the first column it did not handle; the caller finishes the
+// row (and the image borders) with the scalar reference code.
+#include <cstdint>
+#include "CustomImageFilter.h"
+
+namespace simd {
+
+// Which result a Sobel row kernel produces
+// (Magnitude = L2 norm, MagnitudeL1 = |gx| + |gy|, both clamped to 255)
+enum class SobelOutput { GradX, GradY, Magnitude, MagnitudeL1 };
+
+// Best instruction set supported by the CPU (and compiled into this binary)
+SimdLevel detectSimdLevel();
+
+// Sobel on one row of a single channel image. 'up', 'mid' and 'down' are the rows
+// y-1, y and y+1 (already mirrored at the top / bottom edge). Writes out[x] for
+// x in [1, returned column) and returns the first column left to the caller.
+unsigned int sobelRow(SimdLevel level, SobelOutput what, const unsigned char* up, const unsigned char* mid,
+                      const unsigned char* down, unsigned char* out, unsigned int width);
+
+// Cumulative seam energy for columns [xBegin, xEnd) of one row:
+// out[x] = energy[x] + min(prev[x - 1], prev[x], prev[x + 1]).
+// Needs 1 <= xBegin and xEnd <= width - 1 (no edge handling). Returns the first
+// column not processed.
+unsigned int minimalEnergyRow(SimdLevel level, const unsigned int* prev, const unsigned char* energy,
+                              unsigned int* out, unsigned int xBegin, unsigned int xEnd);
+// Same, also writing the backtrack step (-1, 0, +1 to the cheapest upper neighbour) per column
+unsigned int minimalEnergyRow(SimdLevel level, const unsigned int* prev, const unsigned char* energy,
+                              unsigned int* out, int8_t* directions, unsigned int xBegin, unsigned int xEnd);
+// Same with 16 bit costs (the caller guarantees they cannot overflow)
+unsigned int minimalEnergyRow(SimdLevel level, const uint16_t* prev, const unsigned char* energy,
+                              uint16_t* out, unsigned int xBegin, unsigned int xEnd);
+
+// Forward energy cumulative cost for columns [xBegin, xEnd) of one row ('up' / 'mid' are the
+// greyscale rows y-1 and y, see CustomImageFilter::computeForwardEnergyPathMap). Same range
+// requirements as minimalEnergyRow.
+unsigned int forwardEnergyRow(SimdLevel level, const unsigned int* prev, const unsigned char* up, const unsigned char* mid,
+                              unsigned int* out, unsigned int xBegin, unsigned int xEnd);
+
+// Fixed point BT.601 luma weights: grey = (r * R + g * G + b * B + round) >> kLumaShift.
+// They add up to 1 << kLumaShift, so white stays 255.
+constexpr int kLumaShift = 15;
+constexpr int kLumaR = 9798;
+constexpr int kLumaG = 19234;
+constexpr int kLumaB = 3736;
+constexpr int kLumaRound = 1 << (kLumaShift - 1);
+
+// Luma of one row of an interleaved RGB (channels == 3) or RGBA (4, alpha ignored) image
+// for x in [0, returned column). Other channel counts are left to the caller (returns 0).
+// Never reads past pixel 'width' (RGB rows stop at least 2 pixels short of it).
+unsigned int lumaRow(SimdLevel level, const unsigned char* in, unsigned int channels,
+                     unsigned char* out, unsigned int width);
+
+// Resampling weights are fixed point with kResampleBits fractional bits
+constexpr int kResampleBits = 14;
+
+// Vertical pass of a separable resize over 'count' bytes:
+// out[i] = clamp((sum_k weights[k] * rows[k][i] + round) >> kResampleBits, 0, 255).
+// Returns the first byte not processed.
+unsigned int resampleColumns(SimdLevel level, const unsigned char* const* rows, const int16_t* weights,
+                             unsigned int taps, unsigned char* out, unsigned int count);
+
+// Horizontal pass of a separable resize over one RGB (channels == 3) or RGBA (4) row:
+// out pixel x = sum_k weights[x * taps + k] * in pixel first[x] + k, for x in
+// [0, returned pixel). Stops before windows whose loads would pass 'inWidth' and, for RGB,
+// before the last output pixel (its 4 byte store would pass the row). Other channel
+// counts return 0.
+unsigned int resampleRow(SimdLevel level, const unsigned char* in, unsigned int channels, unsigned int inWidth,
+                         const unsigned int* first, const int16_t* weights, unsigned int taps,
+                         unsigned char* out, unsigned int outWidth);
+
+// 2x2 max pooling of the rows 'row0' and 'row1': out[x] = max of columns 2x and 2x + 1 of
+// both rows, for x in [0, returned column). Needs 2 * outEnd readable columns per row.
+unsigned int downsampleMax2Row(SimdLevel level, const unsigned char* row0, const unsigned char* row1,
+                               unsigned char* out, unsigned int outEnd);
+
+} // namespace simd
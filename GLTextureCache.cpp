@@ -0,0 +1,120 @@
+#include "GLTextureCache.h"
+#include <algorithm>
+#include <cstring>
+#include <spdlog/spdlog.h>
+
+// Sized internal format for glTexStorage2D / glTexImage2D
+static GLenum internalFormatFor(unsigned int channels) {
+    switch (channels) {
+        case 1: return GL_R8;
+        case 2: return GL_RG8;
+        case 3: return GL_RGB8;
+        case 4: return GL_RGBA8;
+        default: return 0;
+    }
+}
+
+// Client pixel format matching internalFormatFor()
+static GLenum pixelFormatFor(unsigned int channels) {
+    switch (channels) {
+        case 1: return GL_RED;
+        case 2: return GL_RG;
+        case 3: return GL_RGB;
+        default: return GL_RGBA;
+    }
+}
+
+bool GLTextureCache::allocate(unsigned int w, unsigned int h, unsigned int c) {
+    const GLenum internalFormat = internalFormatFor(c);
+    if (internalFormat == 0) {
+        spdlog::error("GLTextureCache: unsupported number of channels: {}", c);
+        return false;
+    }
+
+    // Immutable storage cannot be respecified, so growing always starts from a new texture
+    if (texture != 0) glDeleteTextures(1, &texture);
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    if (GLAD_GL_VERSION_4_2 || GLAD_GL_ARB_texture_storage) {
+        glTexStorage2D(GL_TEXTURE_2D, 1, internalFormat, w, h);
+    } else {
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, w, h, 0, pixelFormatFor(c), GL_UNSIGNED_BYTE, nullptr);
+    }
+
+    capacityWidth = w;
+    capacityHeight = h;
+    channels = c;
+    generation = 0;
+    return true;
+}
+
+bool GLTextureCache::reserve(unsigned int w, unsigned int h, unsigned int c) {
+    if (texture != 0 && w <= capacityWidth && h <= capacityHeight && c == channels) return true;
+    return allocate(std::max(w, capacityWidth), std::max(h, capacityHeight), c);
+}
+
+bool GLTextureCache::update(const ImageData& image) {
+    if (image.getGeneration() == generation) return false;
+    // Remembered even if the upload fails below, so a bad image is only reported once
+    generation = image.getGeneration();
+
+    if (image.getWidth() == 0 || image.getHeight() == 0 || image.pixels.empty()) {
+        spdlog::error("GLTextureCache: ImageData has no pixel data.");
+        return false;
+    }
+    const uint64_t uploading = generation;
+    if (!reserve(image.getWidth(), image.getHeight(), image.getChannels())) return false;
+    generation = uploading; // allocate() resets it
+
+    width = image.getWidth();
+    height = image.getHeight();
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    if (asyncUpload && uploadThroughPbo(image)) return true;
+
+    // Rows may be padded (pitched images), let GL skip the padding
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, image.getStride());
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, pixelFormatFor(channels), GL_UNSIGNED_BYTE, image.pixels.data());
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    return true;
+}
+
+// Copies the rows into a freshly orphaned buffer (no wait for the GPU to finish reading
+// the previous upload) and lets glTexSubImage2D read from there. Returns false if the
+// buffer could not be mapped, the caller then uploads directly.
+bool GLTextureCache::uploadThroughPbo(const ImageData& image) {
+    const size_t rowBytes = static_cast<size_t>(image.getWidth()) * image.getChannels();
+    const size_t bytes = rowBytes * image.getHeight();
+    if (pbo == 0) glGenBuffers(1, &pbo);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+    pboBytes = std::max(pboBytes, bytes);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(pboBytes), nullptr, GL_STREAM_DRAW);
+    auto* staging = static_cast<unsigned char*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, static_cast<GLsizeiptr>(bytes),
+                                                                 GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+    if (staging == nullptr) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return false;
+    }
+    for (unsigned int y = 0; y < image.getHeight(); ++y) {
+        std::memcpy(staging + y * rowBytes, image.getRow(y), rowBytes);
+    }
+    const bool mapped = glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_TRUE;
+    if (mapped) {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, pixelFormatFor(channels), GL_UNSIGNED_BYTE, nullptr);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    return mapped; // a lost mapping (e.g. display mode change) falls back to the direct upload
+}
+
+void GLTextureCache::release() {
+    if (texture != 0) glDeleteTextures(1, &texture);
+    if (pbo != 0) glDeleteBuffers(1, &pbo);
+    texture = 0;
+    pbo = 0;
+    pboBytes = 0;
+    capacityWidth = capacityHeight = channels = 0;
+    width = height = 0;
+    generation = 0;
+}
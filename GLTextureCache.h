@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <glad/glad.h>
+#include "ImageData.h"
+
+// A display texture that only re-uploads when the image it shows changed (same
+// ImageData::getGeneration() as last time -> nothing to do). The storage is allocated
+// once, at the largest size seen or reserved (immutable glTexStorage2D where available),
+// and smaller images are written into its top left corner with glTexSubImage2D, so a
+// shrinking seam carved image never reallocates. Draw the corner with getMaxU()/getMaxV()
+// as far texture coordinates.
+// With 'asyncUpload' the pixels go through a pixel buffer object: glTexSubImage2D then
+// returns at once and the driver copies into the texture when it suits it.
+class GLTextureCache {
+private:
+    GLuint texture = 0;
+    GLuint pbo = 0;
+    size_t pboBytes = 0;
+    bool asyncUpload = false;
+    uint64_t generation = 0;              // of the last uploaded image (0: none)
+    unsigned int capacityWidth = 0;       // texture storage size
+    unsigned int capacityHeight = 0;
+    unsigned int channels = 0;
+    unsigned int width = 0, height = 0;   // of the last uploaded image
+
+    bool allocate(unsigned int w, unsigned int h, unsigned int c);
+    bool uploadThroughPbo(const ImageData& image);
+
+public:
+    explicit GLTextureCache(bool asyncUpload = false) : asyncUpload(asyncUpload) {}
+    ~GLTextureCache() { release(); }
+    GLTextureCache(const GLTextureCache&) = delete;
+    GLTextureCache& operator=(const GLTextureCache&) = delete;
+
+    // Allocate the storage up front, e.g. for the largest size a result can have
+    bool reserve(unsigned int w, unsigned int h, unsigned int c);
+    // Upload 'image' unless it is the one uploaded last. Returns true if it uploaded.
+    bool update(const ImageData& image);
+    // Delete the GL objects (needs the GL context, so call it before tearing that down)
+    void release();
+
+    GLuint getId() const { return texture; }
+    unsigned int getWidth() const { return width; }
+    unsigned int getHeight() const { return height; }
+    // Texture coordinates of the bottom right corner of the last uploaded image
+    float getMaxU() const { return capacityWidth ? static_cast<float>(width) / capacityWidth : 1.0f; }
+    float getMaxV() const { return capacityHeight ? static_cast<float>(height) / capacityHeight : 1.0f; }
+};
@@ -1,8 +1,36 @@
 #pragma once
+#include <atomic>
+#include <cstdint>
 #include <vector>
 #include <string>
+#include <cstring>
+#include <utility>
 #include <glad/glad.h>
 #include <spdlog/spdlog.h>
+#include "AlignedAllocator.h"
+
+// Row layout of an ImageData buffer.
+//  - Packed:  rows follow each other without gap (stride == width). This is the
+//             classic layout, 'pixels' can be read as width*height*channels bytes.
+//  - Aligned: the row stride is rounded up to kRowAlignment pixels, so every row
+//             starts on a 32 byte boundary. Shrinking the logical width keeps the
+//             stride, which makes seam removal allocation-free and row-local.
+enum class RowLayout { Packed, Aligned };
+
+// Non-owning view on (part of) an image buffer. Shares storage with its ImageData,
+// so it is only valid as long as the image is alive and not resized.
+template <typename Pixel>
+struct BasicImageView {
+    Pixel* data = nullptr;      // First pixel of row 0
+    unsigned int width = 0;     // Logical width in pixels
+    unsigned int height = 0;    // Number of rows
+    unsigned int channels = 0;  // Channels per pixel
+    unsigned int stride = 0;    // Row pitch in pixels (>= width)
+
+    Pixel* row(unsigned int y) const { return data + static_cast<size_t>(y) * stride * channels; }
+};
+using ImageView = BasicImageView<unsigned char>;
+using ConstImageView = BasicImageView<const unsigned char>;
 
 class ImageData {
 private:
@@ -10,34 +38,129 @@ private:
     unsigned int width = 0;     // Image width in pixels
     unsigned int height = 0;    // Image height in pixels
     unsigned int channels = 0;  // Number of channels per pixel (1..4 typical)
-    
+    unsigned int stride = 0;    // Row pitch in pixels (== width for packed images)
+    RowLayout layout = RowLayout::Packed;
+    uint64_t generation = nextGeneration(); // see getGeneration()
+
+    static uint64_t nextGeneration() {
+        static std::atomic<uint64_t> counter{0};
+        return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+    static unsigned int strideFor(unsigned int w, RowLayout l) {
+        if (l == RowLayout::Packed) return w;
+        return (w + kRowAlignment - 1) / kRowAlignment * kRowAlignment;
+    }
+
 public:
-    std::vector<unsigned char> pixels; // Interleaved pixel buffer
+    // Aligned rows are padded to a multiple of this many pixels. With 32 pixels a row
+    // is a multiple of 32 bytes for any channel count (one AVX2 register).
+    static constexpr unsigned int kRowAlignment = 32;
+
+    // Interleaved pixel buffer, 'stride' pixels per row. The buffer itself is 64 byte aligned.
+    std::vector<unsigned char, AlignedAllocator<unsigned char>> pixels;
 
     // Default constructs an 'empty' (0x0x0) image.
     ImageData() : ImageData(0,0,0) {}
-    ImageData(unsigned int w, unsigned int h, unsigned int c)
-        : width(w), height(h), channels(c) {
+    ImageData(unsigned int w, unsigned int h, unsigned int c, RowLayout l = RowLayout::Packed)
+        : width(w), height(h), channels(c), stride(strideFor(w, l)), layout(l) {
             // Allocate & zero-initialize pixel buffer.
             // (Zero fill is useful for predictable initial state / debugging.)
-            pixels.resize(w * h * c, 0);
+            pixels.resize(static_cast<size_t>(stride) * h * c, 0);
     }
 
+    // Copy of 'other' with the requested row layout.
+    ImageData(const ImageData& other, RowLayout l)
+        : ImageData(other.width, other.height, other.channels, l) {
+            copyRowsFrom(other.view());
+    }
+    // Copies get a generation of their own, moves hand theirs over (the moved-from
+    // image gets a new one, its content is gone)
+    ImageData(const ImageData& other)
+        : width(other.width), height(other.height), channels(other.channels), stride(other.stride),
+          layout(other.layout), pixels(other.pixels) {}
+    ImageData(ImageData&& other) noexcept
+        : width(other.width), height(other.height), channels(other.channels), stride(other.stride),
+          layout(other.layout), generation(other.generation), pixels(std::move(other.pixels)) {
+            other.generation = nextGeneration();
+    }
+    ImageData& operator=(const ImageData& other) {
+        if (this != &other) {
+            width = other.width; height = other.height; channels = other.channels;
+            stride = other.stride; layout = other.layout;
+            pixels = other.pixels; // reuses the capacity
+            markModified();
+        }
+        return *this;
+    }
+    ImageData& operator=(ImageData&& other) noexcept {
+        if (this != &other) {
+            width = other.width; height = other.height; channels = other.channels;
+            stride = other.stride; layout = other.layout;
+            pixels = std::move(other.pixels);
+            generation = other.generation;
+            other.generation = nextGeneration();
+        }
+        return *this;
+    }
+
+    // Process-wide unique id of the current content, e.g. to skip redundant texture uploads.
+    // Resizing, setPixels() and copyRowsFrom() change it; code writing pixels in place
+    // (through 'pixels', getRow() or a view) has to call markModified() itself.
+    uint64_t getGeneration() const { return generation; }
+    void markModified() { generation = nextGeneration(); }
+
     unsigned int getWidth() const { return width; }
     unsigned int getHeight() const { return height; }
     unsigned int getChannels() const { return channels; }
+    unsigned int getStride() const { return stride; }
+    RowLayout getLayout() const { return layout; }
+    bool isPacked() const { return stride == width; }
+
+    // Row pitch in bytes
+    size_t getRowPitch() const { return static_cast<size_t>(stride) * channels; }
+
+    // Pointer to the first byte of row y
+    unsigned char* getRow(unsigned int y) { return pixels.data() + y * getRowPitch(); }
+    const unsigned char* getRow(unsigned int y) const { return pixels.data() + y * getRowPitch(); }
 
+    // Views sharing this image's storage (whole image or a sub-rectangle)
+    ImageView view() { return {pixels.data(), width, height, channels, stride}; }
+    ConstImageView view() const { return {pixels.data(), width, height, channels, stride}; }
+    ImageView view(unsigned int x, unsigned int y, unsigned int w, unsigned int h) {
+        return {getRow(y) + static_cast<size_t>(x) * channels, w, h, channels, stride};
+    }
+    ConstImageView view(unsigned int x, unsigned int y, unsigned int w, unsigned int h) const {
+        return {getRow(y) + static_cast<size_t>(x) * channels, w, h, channels, stride};
+    }
+
+    // Packed images are resized like a flat buffer. Aligned images only change their
+    // logical width while it fits into the stride (no reallocation, rows stay in place).
     void setWidth(unsigned int w) {
+        if (layout == RowLayout::Aligned) {
+            if (w > stride) {
+                ImageData grown(w, height, channels, RowLayout::Aligned);
+                grown.copyRowsFrom(std::as_const(*this).view());
+                *this = std::move(grown);
+            }
+            width = w;
+            markModified();
+            return;
+        }
         width = w;
-        pixels.resize(width * height * channels, 0);
+        stride = w;
+        pixels.resize(static_cast<size_t>(stride) * height * channels, 0);
+        markModified();
     }
     void setHeight(unsigned int h) {
         height = h;
-        pixels.resize(width * height * channels, 0);
+        pixels.resize(static_cast<size_t>(stride) * height * channels, 0);
+        markModified();
     }
     void setChannels(unsigned int c) {
         channels = c;
-        pixels.resize(width * height * channels, 0);
+        pixels.resize(static_cast<size_t>(stride) * height * channels, 0);
+        markModified();
     }
 
     // Translate channel count to an OpenGL format enum suitable for glTexImage2D.
@@ -55,18 +178,35 @@ public:
     }
 
     // Assign pixel data from a raw pointer.
+    // Packed source data of exactly width*height*channels bytes is distributed over the
+    // rows of an aligned image; otherwise the bytes are copied as they are.
     // NOTE: This does NOT validate that 'count' matches width*height*channels.
     void setPixels(const unsigned char* pixels_src, size_t count) {
+        markModified();
         // Check for null pointer and zero count
         if(count == 0 || pixels_src == nullptr) {
             pixels.clear();
             return;
         }
 
+        if (!isPacked() && count == static_cast<size_t>(width) * height * channels) {
+            copyRowsFrom({pixels_src, width, height, channels, width});
+            return;
+        }
+
         // Set the pixel data
         pixels.assign(pixels_src, pixels_src + count);
     }
 
+    // Copy the rows of 'src' (same size as this image) into this image's rows.
+    void copyRowsFrom(const ConstImageView& src) {
+        const size_t rowBytes = static_cast<size_t>(width) * channels;
+        for (unsigned int y = 0; y < height; ++y) {
+            std::memcpy(getRow(y), src.row(y), rowBytes);
+        }
+        markModified();
+    }
+
     // Raw accessors (mutable / const) for OpenGL texture upload or algorithms
     unsigned char* getPixelData() { return pixels.data(); }
     const unsigned char* getPixelData() const { return pixels.data(); }
@@ -75,9 +215,12 @@ public:
 
     /// Print pixel values (debug helper) - heavy for large images.
     void printPixels() const {
-        for (size_t i = 0; i < pixels.size(); ++i) {
-            printf("%u ", pixels[i]);
-            if ((i + 1) % width == 0) printf("\n");
+        for (unsigned int y = 0; y < height; ++y) {
+            const unsigned char* row = getRow(y);
+            for (size_t i = 0; i < static_cast<size_t>(width) * channels; ++i) {
+                printf("%u ", row[i]);
+            }
+            printf("\n");
         }
     }
 };
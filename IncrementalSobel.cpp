@@ -0,0 +1,78 @@
+#include "IncrementalSobel.h"
+#include <algorithm>
+
+void IncrementalSobel::reset(const ImageData& greyscaleImage) {
+    greyscale = greyscaleImage;
+    CustomImageFilter::sobel(greyscale, energy, norm);
+}
+
+void IncrementalSobel::removeSeam(const std::vector<unsigned int>& seam) {
+    removeSeams({seam});
+}
+
+void IncrementalSobel::removeSeams(const std::vector<std::vector<unsigned int>>& seams) {
+    const unsigned int width = greyscale.getWidth();
+    const unsigned int height = greyscale.getHeight();
+    const unsigned int count = static_cast<unsigned int>(seams.size());
+    if (count == 0) return;
+    if (count >= width) {
+        spdlog::error("IncrementalSobel: cannot remove {} seams from an image of width {}.", count, width);
+        return;
+    }
+
+    // Removed columns per row, sorted left to right (seam pixels may come in any row order).
+    // A seam has to cover every row exactly once, checked before anything is written.
+    std::vector<unsigned int> removed(static_cast<size_t>(height) * count, width); // 'width' marks an unvisited row
+    for (unsigned int i = 0; i < count; ++i) {
+        if (seams[i].size() != height) {
+            spdlog::error("IncrementalSobel: invalid seam ({} pixels for a {}x{} image).", seams[i].size(), width, height);
+            return;
+        }
+        for (auto pixelIndex : seams[i]) {
+            const unsigned int row = pixelIndex / width;
+            if (row >= height || removed[row * count + i] != width) {
+                spdlog::error("IncrementalSobel: seam {} does not match a {}x{} image.", i, width, height);
+                return;
+            }
+            removed[row * count + i] = pixelIndex % width;
+        }
+    }
+    for (unsigned int y = 0; y < height; ++y) {
+        std::sort(removed.begin() + y * count, removed.begin() + (y + 1) * count);
+    }
+
+    CustomImageFilter::removeSeams(greyscale, seams);
+    CustomImageFilter::removeSeams(energy, seams);
+    if (greyscale.getWidth() != width - count) return; // rejected (overlapping seams), already logged
+
+    // The j-th removed pixel of a row (sorted) leaves a gap before new column g = s - j.
+    // A pixel left of all j-th gaps of the three rows it reads keeps its old
+    // neighbourhood if its right neighbour is still left of them, and a pixel right of
+    // them keeps it if its left neighbour is right of them. So in row y only the columns
+    // [min(g) - 1, max(g)] (g over rows y-1..y+1) change, for every j.
+    // For a single seam that is [min(s) - 1, max(s)].
+    const int newWidth = static_cast<int>(greyscale.getWidth());
+    for (unsigned int y = 0; y < height; ++y) {
+        const unsigned int rowFirst = y > 0 ? y - 1 : y;
+        const unsigned int rowLast = y + 1 < height ? y + 1 : y;
+
+        int done = 0; // columns below this are already recomputed (intervals grow with j)
+        for (unsigned int j = 0; j < count; ++j) {
+            int minGap = newWidth;
+            int maxGap = 0;
+            for (unsigned int r = rowFirst; r <= rowLast; ++r) {
+                int gap = static_cast<int>(removed[r * count + j]) - static_cast<int>(j);
+                minGap = std::min(minGap, gap);
+                maxGap = std::max(maxGap, gap);
+            }
+
+            int xBegin = std::max({minGap - 1, 0, done});
+            int xEnd = std::min(maxGap, newWidth - 1);
+            for (int x = xBegin; x <= xEnd; ++x) {
+                energy.getRow(y)[x] = CustomImageFilter::sobelAt(greyscale, x, y, norm);
+            }
+            done = std::max(done, xEnd + 1);
+        }
+    }
+    energy.markModified(); // refreshed in place
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <vector>
+#include "ImageData.h"
+#include "CustomImageFilter.h"
+
+// Keeps a greyscale image and its Sobel energy map in sync while seams are removed.
+// Instead of running CustomImageFilter::sobel over the whole image after every removal,
+// the energy buffer is compacted like the image and only the pixels whose 3x3
+// neighbourhood was touched by the seam are recomputed. The result is byte-identical
+// to a full recompute on the carved greyscale image.
+class IncrementalSobel {
+private:
+    ImageData greyscale; // Current (carved) greyscale image
+    ImageData energy;    // Sobel magnitude of 'greyscale'
+    EnergyNorm norm = EnergyNorm::L2;
+
+public:
+    IncrementalSobel() = default;
+    explicit IncrementalSobel(const ImageData& greyscaleImage, EnergyNorm energyNorm = EnergyNorm::L2)
+        : norm(energyNorm) { reset(greyscaleImage); }
+
+    // Start over from a new greyscale image (full Sobel pass, energy buffer reused).
+    void reset(const ImageData& greyscaleImage);
+
+    // Remove a seam (flat pixel indices in the current image, one per row) from the
+    // greyscale image and update the energy map around it.
+    void removeSeam(const std::vector<unsigned int>& seam);
+
+    // Remove several pixel-disjoint seams (see CustomImageFilter::removeSeams) in one
+    // pass and update the energy map around each of them.
+    void removeSeams(const std::vector<std::vector<unsigned int>>& seams);
+
+    const ImageData& getGreyscale() const { return greyscale; }
+    const ImageData& getEnergy() const { return energy; }
+};
@@ -0,0 +1,353 @@
+#include "SeamCarver.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <spdlog/spdlog.h>
+
+SeamCarver::SeamCarver(const ImageData& source, const SeamCarveOptions& carveOptions)
+    : options(carveOptions),
+      image(source, RowLayout::Aligned),
+      sourceWidth(source.getWidth()) {
+    {
+        ScopedStageTimer timer(options.stats, CarveStage::Energy);
+        if (options.energyMode == EnergyMode::Forward) {
+            greyscale = CustomImageFilter::toGreyscale(image);
+        } else {
+            sobel = IncrementalSobel(CustomImageFilter::toGreyscale(image), options.energyNorm);
+        }
+    }
+    const unsigned int height = source.getHeight();
+    sourceColumn.resize(static_cast<size_t>(sourceWidth) * height);
+    for (unsigned int y = 0; y < height; ++y) {
+        for (unsigned int x = 0; x < sourceWidth; ++x) sourceColumn[y * sourceWidth + x] = x;
+    }
+    removalOrder.assign(sourceColumn.size(), 0);
+}
+
+// Below this many coarse columns the pyramid saves nothing worth its approximation
+static constexpr unsigned int kPyramidMinWidth = 32;
+// Transport map limits: table cells x source pixels (energy + DP work, ~10 s), and bytes
+// of the two table rows of images kept in memory
+static constexpr uint64_t kTransportMapMaxWork = uint64_t(1) << 30;
+static constexpr uint64_t kTransportMapMaxBytes = uint64_t(512) << 20;
+
+unsigned int SeamCarver::carveStep(unsigned int targetWidth) {
+    const unsigned int width = image.getWidth();
+    const unsigned int height = image.getHeight();
+    if (width <= std::max(targetWidth, 1u)) return 0;
+
+    const bool forward = options.energyMode == EnergyMode::Forward;
+    const unsigned int remaining = width - targetWidth;
+    const unsigned int batch = std::max(1u, static_cast<unsigned int>(remaining * options.seamBatchFraction));
+    const unsigned int levels = std::min(options.pyramidLevels, 8u);
+    const unsigned int factor = 1u << levels;
+    const bool pyramid = factor > 1 && !forward && batch == 1 && width / factor >= kPyramidMinWidth && height / factor >= 2;
+
+    // (a) Dynamic programming minimal energy path map on the incrementally updated energy
+    //     (itself kept up to date incrementally, see (f)), or with forward energy computed
+    //     on the fly from the greyscale image.
+    //     Pyramid: DP on the coarse energy, then only in a band around the coarse seam.
+    std::vector<unsigned int> minimalEnergyPathMap;
+    std::vector<unsigned int> bandStart;
+    const unsigned int bandWidth = std::min(width, 3 * factor); // coarse seam column +- 1 coarse pixel
+    size_t mapBytes = 0;
+    if (pyramid || forward || pathMap.empty()) {
+        ScopedStageTimer timer(options.stats, CarveStage::MinimalPath);
+        if (pyramid) {
+            ImageData coarse = CustomImageFilter::downsampleMax2(sobel.getEnergy());
+            for (unsigned int level = 1; level < levels; ++level) coarse = CustomImageFilter::downsampleMax2(coarse);
+            // Coarse levels are short enough for 16 bit costs from about 4 levels on 4K
+            std::vector<unsigned int> coarseSeam;
+            auto coarsePath = [&](auto cost) {
+                using Cost = decltype(cost);
+                const std::vector<Cost> coarseMap = CustomImageFilter::computeCostMap<Cost>(coarse, ThreadPool::shared());
+                coarseSeam = CustomImageFilter::backtrackCostMap(coarseMap, coarse.getWidth(), coarse.getHeight());
+                mapBytes = coarseMap.size() * sizeof(Cost);
+            };
+            if (CustomImageFilter::costFits<uint16_t>(coarse.getHeight())) coarsePath(uint16_t{});
+            else coarsePath(0u);
+            std::vector<unsigned int> coarseColumn(coarse.getHeight());
+            for (auto pixelIndex : coarseSeam) coarseColumn[pixelIndex / coarse.getWidth()] = pixelIndex % coarse.getWidth();
+            bandStart.resize(height);
+            for (unsigned int y = 0; y < height; ++y) {
+                const unsigned int cx = coarseColumn[y / factor];
+                bandStart[y] = cx > 0 ? (cx - 1) * factor : 0;
+            }
+            minimalEnergyPathMap = CustomImageFilter::computeMinimalEnergyPathMapInBand(sobel.getEnergy(), bandStart, bandWidth);
+            mapBytes += minimalEnergyPathMap.size() * sizeof(unsigned int);
+            pathMap.clear(); // Not maintained by this step
+        } else if (forward) {
+            minimalEnergyPathMap = CustomImageFilter::computeForwardEnergyPathMap(greyscale);
+            mapBytes = minimalEnergyPathMap.size() * sizeof(unsigned int);
+        } else {
+            pathMap = CustomImageFilter::computeMinimalEnergyPathMap(sobel.getEnergy());
+            mapBytes = pathMap.size() * sizeof(unsigned int);
+        }
+    }
+    const std::vector<unsigned int>& map = pyramid || forward ? minimalEnergyPathMap : pathMap;
+
+    // (b) Extract the minimal energy seam, or a batch of disjoint seams
+    std::vector<std::vector<unsigned int>> seams;
+    {
+        ScopedStageTimer timer(options.stats, CarveStage::Backtrack);
+        if (pyramid) {
+            seams.push_back(CustomImageFilter::identityMinEnergySeamInBand(minimalEnergyPathMap, bandStart, bandWidth, width, height));
+        } else if (batch == 1) {
+            seams.push_back(forward ? CustomImageFilter::identityForwardEnergySeam(map, greyscale)
+                                    : CustomImageFilter::identityMinEnergySeam(map, width, height));
+        } else {
+            // Forward energy batches follow the cheapest neighbour above (approximate, like batching itself)
+            seams = CustomImageFilter::identityMinEnergySeams(map, width, height, std::min(batch, remaining));
+        }
+    }
+
+    {
+        ScopedStageTimer timer(options.stats, CarveStage::Removal);
+        // (c) Record when each source pixel goes away
+        for (size_t i = 0; i < seams.size(); ++i) {
+            for (auto pixelIndex : seams[i]) {
+                const unsigned int y = pixelIndex / width;
+                removalOrder[static_cast<size_t>(y) * sourceWidth + sourceColumn[pixelIndex]] = removedSeams + static_cast<unsigned int>(i);
+            }
+        }
+
+        // (d) Remove from colour image and the source column map
+        CustomImageFilter::removeSeams(image, seams);
+        CustomImageFilter::removeSeams(sourceColumn, width, height, seams);
+        if (forward) CustomImageFilter::removeSeams(greyscale, seams);
+    }
+    if (!forward) {
+        // (e) Greyscale + energy, only recomputed around the removed seams
+        ScopedStageTimer timer(options.stats, CarveStage::Energy);
+        sobel.removeSeams(seams);
+    }
+    if (!pathMap.empty()) {
+        // (f) Cumulative map, only recomputed in the cone below the removed seams
+        ScopedStageTimer timer(options.stats, CarveStage::MinimalPath);
+        updatePathMap(seams, width);
+    }
+
+    removedSeams += static_cast<unsigned int>(seams.size());
+    if (options.stats) {
+        options.stats->addSeams(seams.size());
+        // Path map + seam pixel lists are the per-iteration allocations
+        options.stats->addAllocated(mapBytes +
+                                    seams.size() * static_cast<uint64_t>(height) * sizeof(unsigned int));
+    }
+    return static_cast<unsigned int>(seams.size());
+}
+
+void SeamCarver::updatePathMap(const std::vector<std::vector<unsigned int>>& seams, unsigned int oldWidth) {
+    const ImageData& energy = sobel.getEnergy();
+    const unsigned int width = energy.getWidth();
+    const unsigned int height = energy.getHeight();
+    const unsigned int count = static_cast<unsigned int>(seams.size());
+
+    // Gaps the seams leave per row (new columns): the j-th removed column s (sorted) of a
+    // row leaves its gap before column s - j, so they span [min(s), max(s) - count + 1]
+    std::vector<unsigned int> gapMin(height, width), gapMax(height, 0);
+    for (const auto& seam : seams) {
+        for (auto pixelIndex : seam) {
+            const unsigned int y = pixelIndex / oldWidth;
+            const unsigned int x = pixelIndex % oldWidth;
+            gapMin[y] = std::min(gapMin[y], x);
+            gapMax[y] = std::max(gapMax[y], x);
+        }
+    }
+    for (unsigned int y = 0; y < height; ++y) gapMax[y] = gapMax[y] + 1 >= count ? gapMax[y] + 1 - count : 0;
+
+    // Energy (see IncrementalSobel) and upper neighbours only change next to the gaps of
+    // the rows y - 1 .. y + 1, plus one column of margin
+    std::vector<unsigned int> dirtyBegin(height), dirtyEnd(height);
+    size_t dirtyCells = 0;
+    for (unsigned int y = 0; y < height; ++y) {
+        unsigned int lo = gapMin[y], hi = gapMax[y];
+        if (y > 0) lo = std::min(lo, gapMin[y - 1]), hi = std::max(hi, gapMax[y - 1]);
+        if (y + 1 < height) lo = std::min(lo, gapMin[y + 1]), hi = std::max(hi, gapMax[y + 1]);
+        dirtyBegin[y] = lo > 2 ? lo - 2 : 0;
+        dirtyEnd[y] = std::min(width, hi + 2);
+        dirtyCells += dirtyEnd[y] > dirtyBegin[y] ? dirtyEnd[y] - dirtyBegin[y] : 0;
+    }
+
+    // Seams spread over the image (batches): the full (parallel) DP is cheaper
+    if (dirtyCells * 2 > static_cast<size_t>(width) * height) {
+        pathMap = CustomImageFilter::computeMinimalEnergyPathMap(energy);
+        return;
+    }
+    CustomImageFilter::removeSeams(pathMap, oldWidth, height, seams);
+    CustomImageFilter::updateMinimalEnergyPathMap(energy, pathMap, dirtyBegin, dirtyEnd);
+}
+
+std::vector<unsigned int> SeamCarver::getRemovalOrder() const {
+    std::vector<unsigned int> order = removalOrder;
+    const unsigned int width = image.getWidth();
+    for (unsigned int y = 0; y < image.getHeight(); ++y) {
+        for (unsigned int x = 0; x < width; ++x) {
+            order[static_cast<size_t>(y) * sourceWidth + sourceColumn[y * width + x]] = removedSeams;
+        }
+    }
+    return order;
+}
+
+std::vector<unsigned int> SeamCarver::computeRemovalOrder(const ImageData& source, unsigned int minWidth,
+                                                          const SeamCarveOptions& carveOptions,
+                                                          const ProgressCallback& progress,
+                                                          const SnapshotCallback& snapshot) {
+    SeamCarver carver(source, carveOptions);
+    const unsigned int total = source.getWidth() > minWidth ? source.getWidth() - minWidth : 0;
+
+    while (carver.getWidth() > minWidth) {
+        if (carver.carveStep(minWidth) == 0) break;
+        if (snapshot) snapshot(carver);
+        if (progress && !progress(carver.getRemovedSeams(), total)) return {};
+    }
+
+    return carver.getRemovalOrder();
+}
+
+// Vertical seams of 'source' down to 'targetWidth'; progress reports (done + removed, total)
+static ImageData carveWidth(const ImageData& source, unsigned int targetWidth, const SeamCarveOptions& carveOptions,
+                            const SeamCarver::ProgressCallback& progress, unsigned int done, unsigned int total) {
+    SeamCarver carver(source, carveOptions);
+    while (carver.getWidth() > targetWidth) {
+        if (carver.carveStep(targetWidth) == 0) break;
+        if (progress && !progress(done + carver.getRemovedSeams(), total)) return ImageData();
+    }
+    return ImageData(carver.getImage(), source.getLayout());
+}
+
+ImageData SeamCarver::carveHeight(const ImageData& source, unsigned int targetHeight,
+                                  const SeamCarveOptions& carveOptions, const ProgressCallback& progress) {
+    const unsigned int total = source.getHeight() > targetHeight ? source.getHeight() - targetHeight : 0;
+    if (total == 0) return source;
+    ImageData carved = carveWidth(CustomImageFilter::transpose(source), targetHeight, carveOptions, progress, 0, total);
+    if (carved.getWidth() == 0) return ImageData();
+    return CustomImageFilter::transpose(carved);
+}
+
+ImageData SeamCarver::insertSeams(const ImageData& source, unsigned int targetWidth,
+                                  const SeamCarveOptions& carveOptions, const ProgressCallback& progress) {
+    if (targetWidth < source.getWidth() || (targetWidth > source.getWidth() && source.getWidth() < 2)) {
+        spdlog::error("insertSeams: invalid target width {} for an image of width {}.", targetWidth, source.getWidth());
+        return ImageData();
+    }
+    const unsigned int total = targetWidth - source.getWidth();
+    ImageData enlarged = source;
+    while (enlarged.getWidth() < targetWidth) {
+        // At most half of the current width per round, otherwise the same low energy
+        // region gets stretched over and over (Avidan & Shamir)
+        const unsigned int width = enlarged.getWidth();
+        const unsigned int count = std::min(targetWidth - width, width / 2);
+        const unsigned int done = width - source.getWidth();
+        auto roundProgress = [&](unsigned int removed, unsigned int) { return !progress || progress(done + removed, total); };
+        const std::vector<unsigned int> order = computeRemovalOrder(enlarged, width - count, carveOptions, roundProgress);
+        if (order.empty()) return ImageData();
+        enlarged = CustomImageFilter::applySeamInsertion(enlarged, order.data(), width + count);
+        if (enlarged.getWidth() == 0) return ImageData();
+    }
+    return enlarged;
+}
+
+unsigned int SeamCarver::removeCheapestSeam(ImageData& image, bool horizontal, const SeamCarveOptions& carveOptions) {
+    ImageData work = horizontal ? CustomImageFilter::transpose(image) : std::move(image);
+    const ImageData grey = CustomImageFilter::toGreyscale(work);
+
+    std::vector<unsigned int> map;
+    unsigned int cost;
+    if (carveOptions.energyMode == EnergyMode::Forward) {
+        map = CustomImageFilter::computeForwardEnergyPathMap(grey);
+        const std::vector<unsigned int> seam = CustomImageFilter::identityForwardEnergySeam(map, grey);
+        cost = map[seam.front()]; // Seam starts in the last row with the total cost
+        CustomImageFilter::removeSeam(work, seam);
+    } else {
+        // Backtrack through the DP's step plane, the seam comes out as columns ready for removal
+        std::vector<int8_t> directions;
+        map = CustomImageFilter::computeMinimalEnergyPathMap(CustomImageFilter::sobel(grey, carveOptions.energyNorm), directions,
+                                                             ThreadPool::shared());
+        const std::vector<unsigned int> columns =
+            CustomImageFilter::identityMinEnergySeamColumns(map, directions, work.getWidth(), work.getHeight());
+        cost = map[static_cast<size_t>(work.getHeight() - 1) * work.getWidth() + columns.back()];
+        CustomImageFilter::removeSeamColumns(work, columns);
+    }
+
+    image = horizontal ? CustomImageFilter::transpose(work) : std::move(work);
+    return cost;
+}
+
+ImageData SeamCarver::retarget(const ImageData& source, unsigned int targetWidth, unsigned int targetHeight,
+                               const SeamCarveOptions& carveOptions, RetargetOrder order, const ProgressCallback& progress) {
+    const unsigned int width = source.getWidth();
+    const unsigned int height = source.getHeight();
+    if (targetWidth == 0 || targetHeight == 0 || targetWidth > width || targetHeight > height) {
+        spdlog::error("retarget: invalid target size {}x{} for an image of {}x{}.", targetWidth, targetHeight, width, height);
+        return ImageData();
+    }
+    const unsigned int columns = width - targetWidth;
+    const unsigned int rows = height - targetHeight;
+
+    // Every table cell recomputes the energy of a full image and two table rows of images are
+    // kept, so large changes of large images would run for hours or exhaust memory
+    const uint64_t tableCells = static_cast<uint64_t>(rows + 1) * (columns + 1);
+    const uint64_t pixels = static_cast<uint64_t>(width) * height;
+    if (order == RetargetOrder::TransportMap && rows != 0 && columns != 0 &&
+        (tableCells * pixels > kTransportMapMaxWork ||
+         2 * static_cast<uint64_t>(columns + 1) * pixels * source.getChannels() > kTransportMapMaxBytes)) {
+        spdlog::warn("retarget: transport map of {}x{} cells too large for an image of {}x{}, carving width first.",
+                     rows + 1, columns + 1, width, height);
+        order = RetargetOrder::WidthFirst;
+    }
+
+    if (order == RetargetOrder::WidthFirst || rows == 0 || columns == 0) {
+        const unsigned int total = columns + rows;
+        ImageData carved = columns ? carveWidth(source, targetWidth, carveOptions, progress, 0, total) : source;
+        if (rows == 0 || carved.getWidth() == 0) return carved;
+        auto heightProgress = [&](unsigned int removed, unsigned int) { return !progress || progress(columns + removed, total); };
+        return carveHeight(carved, targetHeight, carveOptions, heightProgress);
+    }
+
+    // Transport map: T(r, c) = minimal cost of removing r rows and c columns,
+    //   T(r, c) = min(T(r - 1, c) + cost of a horizontal seam of image(r - 1, c),
+    //                 T(r, c - 1) + cost of a vertical seam of image(r, c - 1)).
+    // Only the images of the previous and current table row are kept.
+    const uint64_t cells = tableCells - 1;
+    uint64_t done = 0;
+    auto step = [&]() {
+        ++done;
+        return !progress || progress(static_cast<unsigned int>(std::min<uint64_t>(done * 100 / cells, 100)), 100);
+    };
+
+    std::vector<uint64_t> previousCost(columns + 1), currentCost(columns + 1);
+    std::vector<ImageData> previous(columns + 1), current(columns + 1);
+    previous[0] = source;
+    for (unsigned int c = 1; c <= columns; ++c) {
+        previous[c] = previous[c - 1];
+        previousCost[c] = previousCost[c - 1] + removeCheapestSeam(previous[c], false, carveOptions);
+        if (!step()) return ImageData();
+    }
+
+    for (unsigned int r = 1; r <= rows; ++r) {
+        current[0] = previous[0];
+        currentCost[0] = previousCost[0] + removeCheapestSeam(current[0], true, carveOptions);
+        if (!step()) return ImageData();
+
+        for (unsigned int c = 1; c <= columns; ++c) {
+            ImageData fromAbove = previous[c];
+            const uint64_t costAbove = previousCost[c] + removeCheapestSeam(fromAbove, true, carveOptions);
+            ImageData fromLeft = current[c - 1];
+            const uint64_t costLeft = currentCost[c - 1] + removeCheapestSeam(fromLeft, false, carveOptions);
+
+            // Ties prefer the vertical seam (width first)
+            if (costLeft <= costAbove) {
+                current[c] = std::move(fromLeft);
+                currentCost[c] = costLeft;
+            } else {
+                current[c] = std::move(fromAbove);
+                currentCost[c] = costAbove;
+            }
+            if (!step()) return ImageData();
+        }
+        std::swap(previous, current);
+        std::swap(previousCost, currentCost);
+    }
+
+    return ImageData(previous[columns], source.getLayout());
+}
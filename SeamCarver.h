@@ -0,0 +1,100 @@
+#pragma once
+#include <functional>
+#include <vector>
+#include "ImageData.h"
+#include "CustomImageFilter.h"
+#include "IncrementalSobel.h"
+#include "CarveStats.h"
+
+// Settings shared by all seam carving passes
+struct SeamCarveOptions {
+    float seamBatchFraction = 0.0f;   // Share of the remaining seams removed per DP pass (0 = one seam, exact)
+    EnergyNorm energyNorm = EnergyNorm::L2;   // Backward energy only
+    EnergyMode energyMode = EnergyMode::Backward;
+    unsigned int pyramidLevels = 0;   // Coarse-to-fine: find each seam on the energy downsampled 2^levels
+                                      // times, then refine it in a narrow band at full resolution
+                                      // (backward energy, single seams; 0 = off)
+    CarveStats* stats = nullptr;      // Optional per-stage timing sink (not part of the result)
+};
+
+// Order of vertical and horizontal seam removals when both dimensions shrink
+enum class RetargetOrder {
+    WidthFirst,  // All vertical seams, then all horizontal seams (incremental, fast)
+    TransportMap // Interleaving chosen by the Avidan & Shamir transport map: one seam per cell of a
+                 // (removed rows + 1) x (removed columns + 1) table, every cell keeping the cheaper of
+                 // its two predecessors (a DP, not a search of all orders). Meant for small size
+                 // changes; falls back to WidthFirst when the table would be too large for the image.
+};
+
+// Removes vertical seams from an image step by step while remembering, for every
+// pixel of the source image, after how many removed seams it disappeared.
+// That removal order makes any later target width a single filter pass
+// (CustomImageFilter::applySeamOrder) instead of a new carve.
+class SeamCarver {
+private:
+    SeamCarveOptions options;
+    ImageData image;                        // Carved colour image (aligned rows)
+    IncrementalSobel sobel;                 // Backward energy: greyscale + energy of 'image'
+    ImageData greyscale;                    // Forward energy: greyscale of 'image' (no energy map needed)
+    std::vector<unsigned int> pathMap;      // Backward energy: cumulative map of the energy, updated incrementally
+    unsigned int sourceWidth = 0;
+    std::vector<unsigned int> sourceColumn; // Per current pixel: its column in the source image
+    std::vector<unsigned int> removalOrder; // Per source pixel: number of seams removed before it
+    unsigned int removedSeams = 0;
+
+    // Brings 'pathMap' in sync with the energy after 'seams' (old coordinates) were removed
+    void updatePathMap(const std::vector<std::vector<unsigned int>>& seams, unsigned int oldWidth);
+
+public:
+    // Called with (removed seams, total seams); return false to cancel
+    using ProgressCallback = std::function<bool(unsigned int, unsigned int)>;
+    // Called after every carving step with the carver (image and energy so far). Runs on the
+    // carving thread: it should only copy what it needs, and not on every call.
+    using SnapshotCallback = std::function<void(const SeamCarver&)>;
+
+    explicit SeamCarver(const ImageData& source, const SeamCarveOptions& carveOptions = {});
+
+    // One DP pass: removes one seam (or a batch, see SeamCarveOptions) but never goes
+    // below 'targetWidth'. Returns the number of seams removed.
+    unsigned int carveStep(unsigned int targetWidth);
+
+    const ImageData& getImage() const { return image; }
+    // Sobel energy of the carved image (empty in forward energy mode)
+    const ImageData& getEnergy() const { return sobel.getEnergy(); }
+    unsigned int getWidth() const { return image.getWidth(); }
+    unsigned int getRemovedSeams() const { return removedSeams; }
+
+    // Removal order of every source pixel (row-major, source size). Pixels still in the
+    // image get getRemovedSeams(), i.e. they survive every width >= getWidth().
+    std::vector<unsigned int> getRemovalOrder() const;
+
+    // Carve 'source' down to 'minWidth' and return its removal order. Returns an empty
+    // vector if 'progress' cancelled the computation. 'snapshot' can show the partial
+    // result: at width w the carved image equals applySeamOrder(source, order, w).
+    static std::vector<unsigned int> computeRemovalOrder(const ImageData& source, unsigned int minWidth,
+                                                         const SeamCarveOptions& carveOptions = {},
+                                                         const ProgressCallback& progress = nullptr,
+                                                         const SnapshotCallback& snapshot = nullptr);
+
+    // Enlarge 'source' to 'targetWidth' by duplicating its lowest energy seams
+    // (CustomImageFilter::applySeamInsertion), in rounds of at most half the current width.
+    // Returns an empty image if 'progress' cancelled.
+    static ImageData insertSeams(const ImageData& source, unsigned int targetWidth,
+                                 const SeamCarveOptions& carveOptions = {}, const ProgressCallback& progress = nullptr);
+
+    // Remove horizontal seams down to 'targetHeight'. They are carved as vertical seams of the
+    // transposed image, so energy, DP and removal keep streaming contiguous rows.
+    // Returns an empty image if 'progress' cancelled.
+    static ImageData carveHeight(const ImageData& source, unsigned int targetHeight,
+                                 const SeamCarveOptions& carveOptions = {}, const ProgressCallback& progress = nullptr);
+
+    // One seam of the transport map: removes the cheapest vertical (or, through the transpose,
+    // horizontal) seam from 'image' and returns its cost. Full recompute, no state is shared.
+    static unsigned int removeCheapestSeam(ImageData& image, bool horizontal, const SeamCarveOptions& carveOptions = {});
+
+    // Carve 'source' to targetWidth x targetHeight (both <= the source size).
+    // Returns an empty image if 'progress' cancelled.
+    static ImageData retarget(const ImageData& source, unsigned int targetWidth, unsigned int targetHeight,
+                              const SeamCarveOptions& carveOptions = {}, RetargetOrder order = RetargetOrder::WidthFirst,
+                              const ProgressCallback& progress = nullptr);
+};
@@ -0,0 +1,314 @@
+#include "SeamIndexFile.h"
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <utility>
+#include <spdlog/spdlog.h>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr char kMagic[8] = {'S', 'E', 'A', 'M', 'I', 'D', 'X', '\0'};
+
+uint32_t zigzag(int64_t v) { return static_cast<uint32_t>((v << 1) ^ (v >> 63)); }
+int64_t unzigzag(uint32_t v) { return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1); }
+
+void putVarint(std::vector<unsigned char>& out, uint32_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<unsigned char>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<unsigned char>(v));
+}
+
+// Seams are connected, so a pixel is usually removed shortly before/after the pixel above:
+// deltas to the previous row stay small and mostly fit one byte.
+std::vector<unsigned char> encodeDeltaVarint(const std::vector<unsigned int>& order, unsigned int width) {
+    std::vector<unsigned char> out;
+    out.reserve(order.size() + order.size() / 4);
+    for (size_t i = 0; i < order.size(); ++i) {
+        const int64_t above = i >= width ? order[i - width] : 0;
+        putVarint(out, zigzag(static_cast<int64_t>(order[i]) - above));
+    }
+    return out;
+}
+
+bool decodeDeltaVarint(const unsigned char* data, size_t size, unsigned int width, std::vector<unsigned int>& order) {
+    size_t pos = 0;
+    for (size_t i = 0; i < order.size(); ++i) {
+        uint32_t v = 0;
+        for (unsigned int shift = 0;; shift += 7) {
+            if (pos >= size || shift > 28) return false;
+            const unsigned char byte = data[pos++];
+            if (shift == 28 && (byte & 0x70) != 0) return false; // more than 32 bits
+            v |= static_cast<uint32_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) break;
+        }
+        const int64_t above = i >= width ? order[i - width] : 0;
+        const int64_t value = above + unzigzag(v);
+        if (value < 0 || value > UINT32_MAX) return false;
+        order[i] = static_cast<unsigned int>(value);
+    }
+    return pos == size;
+}
+
+// A removal order down to 'minWidth' removes every value below width - minWidth exactly
+// once per row. Anything else (a damaged file) would make applySeamOrder fail for some widths.
+bool validRemovalOrder(const unsigned int* order, unsigned int width, unsigned int height, unsigned int minWidth) {
+    if (minWidth == 0 || minWidth > width) return false;
+    const unsigned int seams = width - minWidth;
+    std::vector<unsigned int> seenInRow(seams, 0); // row + 1 of the last row the value was seen in
+    for (unsigned int y = 0; y < height; ++y) {
+        const unsigned int* row = order + static_cast<size_t>(y) * width;
+        unsigned int removed = 0;
+        for (unsigned int x = 0; x < width; ++x) {
+            if (row[x] >= seams) continue;
+            if (seenInRow[row[x]] == y + 1) return false;
+            seenInRow[row[x]] = y + 1;
+            ++removed;
+        }
+        if (removed != seams) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+SeamIndexFile::~SeamIndexFile() {
+    close();
+}
+
+SeamIndexFile::SeamIndexFile(SeamIndexFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+SeamIndexFile& SeamIndexFile::operator=(SeamIndexFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        header = other.header;
+        mapping = std::exchange(other.mapping, nullptr);
+        mappingSize = std::exchange(other.mappingSize, 0);
+#ifdef _WIN32
+        fileHandle = std::exchange(other.fileHandle, nullptr);
+        mappingHandle = std::exchange(other.mappingHandle, nullptr);
+#endif
+        // Moving the vector keeps its buffer, so a decoded order pointer stays valid too
+        decoded = std::move(other.decoded);
+        order = std::exchange(other.order, nullptr);
+    }
+    return *this;
+}
+
+void SeamIndexFile::close() {
+#ifdef _WIN32
+    if (mapping) UnmapViewOfFile(mapping);
+    if (mappingHandle) CloseHandle(mappingHandle);
+    if (fileHandle) CloseHandle(fileHandle);
+    fileHandle = nullptr;
+    mappingHandle = nullptr;
+#else
+    if (mapping) munmap(const_cast<unsigned char*>(mapping), mappingSize);
+#endif
+    mapping = nullptr;
+    mappingSize = 0;
+    decoded.clear();
+    order = nullptr;
+}
+
+bool SeamIndexFile::open(const std::string& path) {
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    fileHandle = file;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart < static_cast<LONGLONG>(sizeof(SeamIndexHeader))) {
+        spdlog::error("Seam index file too small: {}", path);
+        close();
+        return false;
+    }
+    mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mappingHandle) {
+        spdlog::error("Failed to map seam index file: {}", path);
+        close();
+        return false;
+    }
+    mapping = static_cast<const unsigned char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    mappingSize = static_cast<size_t>(size.QuadPart);
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(SeamIndexHeader))) {
+        spdlog::error("Seam index file too small: {}", path);
+        ::close(fd);
+        return false;
+    }
+    void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // The mapping keeps the file alive
+    if (view == MAP_FAILED) {
+        spdlog::error("Failed to map seam index file: {}", path);
+        return false;
+    }
+    mapping = static_cast<const unsigned char*>(view);
+    mappingSize = static_cast<size_t>(st.st_size);
+#endif
+    if (!mapping) {
+        spdlog::error("Failed to map seam index file: {}", path);
+        close();
+        return false;
+    }
+
+    std::memcpy(&header, mapping, sizeof(header));
+    const size_t pixelCount = static_cast<size_t>(header.width) * header.height;
+    const unsigned char* payload = mapping + sizeof(SeamIndexHeader);
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion) {
+        spdlog::error("Not a seam index file (or unsupported version): {}", path);
+        close();
+        return false;
+    }
+    if (header.payloadBytes != mappingSize - sizeof(SeamIndexHeader)) {
+        spdlog::error("Truncated seam index file: {}", path);
+        close();
+        return false;
+    }
+
+    switch (static_cast<SeamIndexEncoding>(header.encoding)) {
+        case SeamIndexEncoding::Raw:
+            if (header.payloadBytes != pixelCount * sizeof(unsigned int)) {
+                spdlog::error("Seam index payload does not match {}x{}: {}", header.width, header.height, path);
+                close();
+                return false;
+            }
+            order = reinterpret_cast<const unsigned int*>(payload);
+            break;
+        case SeamIndexEncoding::DeltaVarint:
+            // Every value takes at least one byte: reject impossible sizes before allocating
+            if (header.width == 0 || header.height == 0 || pixelCount > header.payloadBytes) {
+                spdlog::error("Corrupt seam index payload: {}", path);
+                close();
+                return false;
+            }
+            decoded.resize(pixelCount);
+            if (!decodeDeltaVarint(payload, header.payloadBytes, header.width, decoded)) {
+                spdlog::error("Corrupt seam index payload: {}", path);
+                close();
+                return false;
+            }
+            order = decoded.data();
+            break;
+        default:
+            spdlog::error("Unknown seam index encoding {}: {}", header.encoding, path);
+            close();
+            return false;
+    }
+    // One pass over the plane (this also pages in a raw mapping, which the first preview reads anyway)
+    if (!validRemovalOrder(order, header.width, header.height, header.minWidth)) {
+        spdlog::error("Corrupt seam index payload: {}", path);
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool SeamIndexFile::matches(const ImageData& source, unsigned int minWidth, const SeamCarveOptions& options) const {
+    return isOpen() &&
+           header.width == source.getWidth() && header.height == source.getHeight() &&
+           header.minWidth <= minWidth &&
+           header.energyNorm == static_cast<uint32_t>(options.energyNorm) &&
+           header.energyMode == static_cast<uint32_t>(options.energyMode) &&
+           header.seamBatchFraction == options.seamBatchFraction &&
+           header.pyramidLevels == options.pyramidLevels &&
+           header.fingerprint == fingerprint(source);
+}
+
+bool SeamIndexFile::write(const std::string& path, const ImageData& source, const std::vector<unsigned int>& removalOrder,
+                          unsigned int minWidth, const SeamCarveOptions& options, SeamIndexEncoding encoding) {
+    const size_t pixelCount = static_cast<size_t>(source.getWidth()) * source.getHeight();
+    if (removalOrder.size() != pixelCount) {
+        spdlog::error("Removal order size {} does not match image {}x{}", removalOrder.size(), source.getWidth(), source.getHeight());
+        return false;
+    }
+
+    std::vector<unsigned char> varint;
+    if (encoding == SeamIndexEncoding::DeltaVarint) varint = encodeDeltaVarint(removalOrder, source.getWidth());
+
+    SeamIndexHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.encoding = static_cast<uint32_t>(encoding);
+    header.width = source.getWidth();
+    header.height = source.getHeight();
+    header.minWidth = minWidth;
+    header.energyNorm = static_cast<uint32_t>(options.energyNorm);
+    header.energyMode = static_cast<uint32_t>(options.energyMode);
+    header.seamBatchFraction = options.seamBatchFraction;
+    header.pyramidLevels = options.pyramidLevels;
+    header.fingerprint = fingerprint(source);
+    header.payloadBytes = encoding == SeamIndexEncoding::Raw ? pixelCount * sizeof(unsigned int) : varint.size();
+
+    // Write next to the target and rename, so a concurrent reader never maps a half written file.
+    // The temporary name is unique per process and call, concurrent writers do not share it.
+    static std::atomic<unsigned int> writeCount{0};
+#ifdef _WIN32
+    const unsigned long processId = GetCurrentProcessId();
+#else
+    const long processId = static_cast<long>(getpid());
+#endif
+    const std::string tmpPath = path + ".tmp" + std::to_string(processId) + "." + std::to_string(writeCount++);
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            spdlog::error("Failed to create seam index file: {}", tmpPath);
+            return false;
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        if (encoding == SeamIndexEncoding::Raw) {
+            out.write(reinterpret_cast<const char*>(removalOrder.data()), static_cast<std::streamsize>(header.payloadBytes));
+        } else {
+            out.write(reinterpret_cast<const char*>(varint.data()), static_cast<std::streamsize>(varint.size()));
+        }
+        if (!out) {
+            spdlog::error("Failed to write seam index file: {}", tmpPath);
+            return false;
+        }
+    }
+#ifdef _WIN32
+    std::remove(path.c_str()); // rename() does not replace an existing file here
+#endif
+    if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        spdlog::error("Failed to move seam index file into place: {}", path);
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+uint64_t SeamIndexFile::fingerprint(const ImageData& source) {
+    uint64_t hash = 14695981039346656037ull;
+    auto mix = [&hash](const unsigned char* data, size_t size) {
+        for (size_t i = 0; i < size; ++i) {
+            hash ^= data[i];
+            hash *= 1099511628211ull;
+        }
+    };
+    const uint32_t dims[3] = {source.getWidth(), source.getHeight(), source.getChannels()};
+    mix(reinterpret_cast<const unsigned char*>(dims), sizeof(dims));
+    const size_t rowBytes = static_cast<size_t>(source.getWidth()) * source.getChannels();
+    for (unsigned int y = 0; y < source.getHeight(); ++y) mix(source.getRow(y), rowBytes);
+    return hash;
+}
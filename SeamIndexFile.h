@@ -0,0 +1,77 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "ImageData.h"
+#include "SeamCarver.h"
+
+// How the removal order plane is stored after the header
+enum class SeamIndexEncoding : uint32_t {
+    Raw = 0,        // W*H little endian uint32, memory-mapped without copy
+    DeltaVarint = 1 // Per pixel zigzag delta to the pixel above, LEB128 varint (decoded on open)
+};
+
+// On-disk header of a seam index file, followed by the removal order plane.
+// 64 bytes so the raw plane starts cache line aligned in the mapping.
+struct SeamIndexHeader {
+    char magic[8];              // "SEAMIDX\0"
+    uint32_t version;
+    uint32_t encoding;          // SeamIndexEncoding
+    uint32_t width;
+    uint32_t height;
+    uint32_t minWidth;          // Index is valid for every target width >= minWidth
+    uint32_t energyNorm;        // SeamCarveOptions the index was built with
+    float seamBatchFraction;
+    uint32_t energyMode;
+    uint64_t fingerprint;       // FNV-1a of the source pixels, see SeamIndexFile::fingerprint
+    uint64_t payloadBytes;
+    uint32_t pyramidLevels;     // Zero in files written before coarse-to-fine carving
+    uint8_t padding[4];
+};
+static_assert(sizeof(SeamIndexHeader) == 64, "SeamIndexHeader must stay 64 bytes");
+
+// Seam removal order (see SeamCarver) persisted next to an image, so it is computed once
+// and any later process only maps the file and runs CustomImageFilter::applySeamOrder.
+class SeamIndexFile {
+private:
+    SeamIndexHeader header{};
+    const unsigned char* mapping = nullptr; // Whole file, read only
+    size_t mappingSize = 0;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#endif
+    std::vector<unsigned int> decoded;      // Only used for SeamIndexEncoding::DeltaVarint
+    const unsigned int* order = nullptr;
+
+    void close();
+
+public:
+    static constexpr uint32_t kVersion = 1;
+
+    SeamIndexFile() = default;
+    ~SeamIndexFile();
+    SeamIndexFile(const SeamIndexFile&) = delete;
+    SeamIndexFile& operator=(const SeamIndexFile&) = delete;
+    SeamIndexFile(SeamIndexFile&& other) noexcept;
+    SeamIndexFile& operator=(SeamIndexFile&& other) noexcept;
+
+    // Maps 'path' and validates the header. Returns false (and logs) on any error.
+    bool open(const std::string& path);
+    bool isOpen() const { return order != nullptr; }
+
+    // True if the index was built from 'source' with 'options' and reaches down to 'minWidth'
+    bool matches(const ImageData& source, unsigned int minWidth, const SeamCarveOptions& options = {}) const;
+
+    const SeamIndexHeader& getHeader() const { return header; }
+    // Removal order plane (row-major, width * height), valid while the file stays open
+    const unsigned int* getRemovalOrder() const { return order; }
+
+    // Writes 'removalOrder' of 'source' (carved down to 'minWidth' with 'options') to 'path'
+    static bool write(const std::string& path, const ImageData& source, const std::vector<unsigned int>& removalOrder,
+                      unsigned int minWidth, const SeamCarveOptions& options = {},
+                      SeamIndexEncoding encoding = SeamIndexEncoding::Raw);
+
+    // 64-bit FNV-1a over size, channels and the visible pixels (independent of the row stride)
+    static uint64_t fingerprint(const ImageData& source);
+};
@@ -131,7 +131,9 @@ ImageData SobelShader::apply(const ImageData& image){
     glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
 
     glBindTexture(GL_TEXTURE_2D,sobel_input_tex_id);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH,image.getStride()); // pitched images
     glTexImage2D(GL_TEXTURE_2D,0,image.getGLFormat(),image.getWidth(),image.getHeight(),0,image.getGLFormat(),GL_UNSIGNED_BYTE,image.getPixelData());
+    glPixelStorei(GL_UNPACK_ROW_LENGTH,0);
 
     glBindFramebuffer(GL_FRAMEBUFFER,sobel_fbo);
     glFramebufferTexture2D(GL_FRAMEBUFFER,GL_COLOR_ATTACHMENT0,GL_TEXTURE_2D,sobel_output_tex,0);
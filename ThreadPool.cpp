@@ -0,0 +1,101 @@
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+ThreadPool::ThreadPool(unsigned int threadCount) {
+    if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned int i = 1; i < threadCount; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lk(mtx);
+        stopping = true;
+    }
+    cv.notify_all();
+    for (auto& worker : workers) worker.join();
+}
+
+void ThreadPool::workerLoop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lk(mtx);
+            cv.wait(lk, [&]() { return stopping || !tasks.empty(); });
+            if (stopping && tasks.empty()) return;
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
+
+void ThreadPool::parallelFor(unsigned int count, const std::function<void(unsigned int)>& fn) {
+    if (count == 0) return;
+    if (workers.empty() || count == 1) {
+        for (unsigned int i = 0; i < count; ++i) fn(i);
+        return;
+    }
+
+    // Shared between the caller and the helper tasks. Helpers that start after all
+    // indices were taken return immediately, so the state must outlive this call.
+    struct LoopState {
+        std::atomic<unsigned int> next{0};
+        std::atomic<unsigned int> done{0};
+        std::mutex mtx;
+        std::condition_variable finished;
+    };
+    auto state = std::make_shared<LoopState>();
+    const std::function<void(unsigned int)>* body = &fn;
+    const unsigned int total = count;
+
+    auto runIndices = [state, body, total]() {
+        unsigned int i;
+        while ((i = state->next.fetch_add(1)) < total) {
+            (*body)(i);
+            if (state->done.fetch_add(1) + 1 == total) {
+                std::lock_guard<std::mutex> lk(state->mtx);
+                state->finished.notify_all();
+            }
+        }
+    };
+
+    const unsigned int helpers = std::min(static_cast<unsigned int>(workers.size()), count - 1);
+    {
+        std::lock_guard<std::mutex> lk(mtx);
+        for (unsigned int i = 0; i < helpers; ++i) tasks.emplace_back(runIndices);
+    }
+    if (helpers == 1) cv.notify_one(); else cv.notify_all();
+
+    runIndices();
+
+    // Indices still running on helper threads: meanwhile help with queued chunks of other
+    // loops (e.g. a concurrent carve job) instead of sleeping. Our own helper tasks may be
+    // among them, they return at once.
+    while (state->done.load() != total && runPendingTask()) {
+    }
+
+    // Wait for the rest ('fn' must stay valid until then)
+    std::unique_lock<std::mutex> lk(state->mtx);
+    state->finished.wait(lk, [&]() { return state->done.load() == total; });
+}
+
+bool ThreadPool::runPendingTask() {
+    std::function<void()> task;
+    {
+        std::lock_guard<std::mutex> lk(mtx);
+        if (tasks.empty()) return false;
+        task = std::move(tasks.front());
+        tasks.pop_front();
+    }
+    task();
+    return true;
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool;
+    return pool;
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Small fixed-size thread pool for data-parallel loops.
+// The calling thread always takes part in parallelFor, so a pool with a single
+// thread runs everything inline and adds no synchronization overhead. Several threads
+// may call parallelFor at once (concurrent carve jobs); a caller that ran out of its
+// own indices picks up queued chunks of the other loops while it waits.
+class ThreadPool {
+private:
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mtx; // protects tasks and stopping
+    std::condition_variable cv;
+    bool stopping = false;
+
+    void workerLoop();
+    // Runs one queued task on the calling thread; false if the queue is empty
+    bool runPendingTask();
+
+public:
+    // 'threadCount' includes the calling thread (0 = one per hardware thread)
+    explicit ThreadPool(unsigned int threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Number of threads taking part in parallelFor (workers + caller)
+    unsigned int getThreadCount() const { return static_cast<unsigned int>(workers.size()) + 1; }
+
+    // Runs fn(i) for every i in [0, count) and returns when all calls finished.
+    // Indices are handed out dynamically, so uneven work balances itself.
+    void parallelFor(unsigned int count, const std::function<void(unsigned int)>& fn);
+
+    // Process wide pool sized to the hardware, created on first use
+    static ThreadPool& shared();
+};
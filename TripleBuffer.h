@@ -0,0 +1,40 @@
+#pragma once
+#include <array>
+#include <atomic>
+
+// Lock-free handoff of the latest value from one producer thread to one consumer thread.
+// Three slots: the producer fills its back slot and swaps it with the middle one, the
+// consumer swaps the middle slot with its front slot when a fresh value is there. Values
+// are never copied, and a slot coming back to the producer still holds an old value
+// whose buffers can be reused (e.g. CustomImageFilter::sobel(input, output)).
+// Neither side ever waits; the producer simply overwrites what the consumer skipped.
+template <typename T>
+class TripleBuffer {
+private:
+    static constexpr unsigned int kFresh = 4; // set in 'middle' when it holds an unread value
+
+    std::array<T, 3> slots;
+    std::atomic<unsigned int> middle{1};
+    unsigned int back = 0;  // producer only
+    unsigned int front = 2; // consumer only
+
+public:
+    TripleBuffer() = default;
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    // Producer: slot to fill, then publish() it
+    T& writeBuffer() { return slots[back]; }
+    void publish() { back = middle.exchange(back | kFresh, std::memory_order_acq_rel) & 3; }
+
+    // Consumer: takes the latest published value if there is a new one.
+    // Returns false (and keeps the current front slot) otherwise.
+    bool update() {
+        if ((middle.load(std::memory_order_relaxed) & kFresh) == 0) return false;
+        front = middle.exchange(front, std::memory_order_acq_rel) & 3;
+        return true;
+    }
+    // Consumer: the value taken by the last update() (initially a default constructed T)
+    T& readBuffer() { return slots[front]; }
+    const T& readBuffer() const { return slots[front]; }
+};
@@ -0,0 +1,499 @@
+// Benchmarks for every seam carving stage on synthetic images from 256x256 to 8K.
+// Reported counters:
+//  - items_per_second: processed pixels per second
+//  - bytes_per_pixel:  bytes read + written per pixel by the stage (memory traffic estimate)
+// Filter stages take a SIMD level argument (0 = Scalar, 1 = SSE4.1, 2 = AVX2, clamped to the
+// CPU) so optimized variants can be compared against the scalar reference in one run, e.g.
+//   bench_seamcarve --benchmark_filter=Sobel
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <numeric>
+#include <random>
+#include <tuple>
+#include <utility>
+#include "CustomImageFilter.h"
+#include "ImageData.h"
+#include "SeamCarver.h"
+#include "ThreadPool.h"
+
+namespace {
+
+// Smooth gradient plus noise, so seams are neither trivial nor pure noise
+const ImageData& syntheticImage(unsigned int width, unsigned int height, unsigned int channels) {
+    static std::map<std::tuple<unsigned int, unsigned int, unsigned int>, ImageData> cache;
+    auto it = cache.find({width, height, channels});
+    if (it != cache.end()) return it->second;
+
+    ImageData image(width, height, channels);
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> noise(-24, 24);
+    for (unsigned int y = 0; y < height; ++y) {
+        unsigned char* row = image.getRow(y);
+        for (unsigned int x = 0; x < width; ++x) {
+            const int base = static_cast<int>((x * 255ull) / width + (y * 127ull) / height) / 2;
+            for (unsigned int c = 0; c < channels; ++c) {
+                row[x * channels + c] = static_cast<unsigned char>(std::clamp(base + noise(rng) + static_cast<int>(c) * 16, 0, 255));
+            }
+        }
+    }
+    return cache.emplace(std::make_tuple(width, height, channels), std::move(image)).first->second;
+}
+
+const ImageData& syntheticGrey(unsigned int width, unsigned int height) {
+    return syntheticImage(width, height, 1);
+}
+
+const ImageData& syntheticEnergy(unsigned int width, unsigned int height) {
+    static std::map<std::pair<unsigned int, unsigned int>, ImageData> cache;
+    auto it = cache.find({width, height});
+    if (it != cache.end()) return it->second;
+    return cache.emplace(std::make_pair(width, height), CustomImageFilter::sobel(syntheticGrey(width, height))).first->second;
+}
+
+// Selects the SIMD level from the benchmark argument and restores the default afterwards
+struct ScopedSimdLevel {
+    SimdLevel previous;
+    explicit ScopedSimdLevel(int64_t level) : previous(CustomImageFilter::getSimdLevel()) {
+        CustomImageFilter::setSimdLevel(static_cast<SimdLevel>(level));
+    }
+    ~ScopedSimdLevel() { CustomImageFilter::setSimdLevel(previous); }
+};
+
+void setCounters(benchmark::State& state, unsigned int width, unsigned int height, double bytesPerPixel) {
+    const int64_t pixels = static_cast<int64_t>(width) * height;
+    state.SetItemsProcessed(state.iterations() * pixels);
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * pixels * bytesPerPixel));
+    state.counters["bytes_per_pixel"] = bytesPerPixel;
+    state.counters["simd"] = static_cast<double>(CustomImageFilter::getSimdLevel());
+}
+
+// 256^2 .. 8K
+void imageSizes(benchmark::internal::Benchmark* b) {
+    const std::pair<int, int> sizes[] = {{256, 256}, {512, 512}, {1024, 1024}, {1920, 1080}, {3840, 2160}, {7680, 4320}};
+    for (auto [w, h] : sizes) b->Args({w, h});
+}
+
+// Same sizes, each with every SIMD level
+void imageSizesAndSimd(benchmark::internal::Benchmark* b) {
+    const std::pair<int, int> sizes[] = {{256, 256}, {512, 512}, {1024, 1024}, {1920, 1080}, {3840, 2160}, {7680, 4320}};
+    for (auto [w, h] : sizes) {
+        for (int level = 0; level <= static_cast<int>(CustomImageFilter::getSupportedSimdLevel()); ++level) b->Args({w, h, level});
+    }
+}
+
+// imageSizesAndSimd for every resampling filter (0 = Bilinear, 1 = Bicubic, 2 = Area)
+void imageSizesSimdAndFilter(benchmark::internal::Benchmark* b) {
+    const std::pair<int, int> sizes[] = {{512, 512}, {1920, 1080}, {3840, 2160}};
+    for (auto [w, h] : sizes) {
+        for (int level = 0; level <= static_cast<int>(CustomImageFilter::getSupportedSimdLevel()); ++level) {
+            for (int filter : {0, 1, 2}) b->Args({w, h, level, filter});
+        }
+    }
+}
+
+// 256^2 .. 1024^2, for the quadratic baseline
+void smallImageSizes(benchmark::internal::Benchmark* b) {
+    const std::pair<int, int> sizes[] = {{256, 256}, {512, 512}, {1024, 1024}};
+    for (auto [w, h] : sizes) b->Args({w, h});
+}
+
+// 1080p .. 8K with 2 and 3 pyramid levels (coarse-to-fine only pays off on large images)
+void largeImageSizesAndPyramid(benchmark::internal::Benchmark* b) {
+    const std::pair<int, int> sizes[] = {{1920, 1080}, {3840, 2160}, {7680, 4320}};
+    for (auto [w, h] : sizes) {
+        for (int levels : {2, 3}) b->Args({w, h, levels});
+    }
+}
+
+void BM_ToGreyscale(benchmark::State& state) {
+    const unsigned int w = state.range(0), h = state.range(1);
+    ScopedSimdLevel simd(state.range(2));
+    const ImageData& image = syntheticImage(w, h, 3);
+    for (auto _ : state) {
+        ImageData grey = CustomImageFilter::toGreyscale(image);
+        benchmark::DoNotOptimize(grey.pixels.data());
+    }
+    setCounters(state, w, h, 3 + 1);
+}
+
+void BM_SobelX(benchmark::State& state) {
+    const unsigned int w = state.range(0), h = state.range(1);
+    ScopedSimdLevel simd(state.range(2));
+    const ImageData& grey = syntheticGrey(w, h);
+    for (auto _ : state) {
+        ImageData gx = CustomImageFilter::sobelX(grey);
+        benchmark::DoNotOptimize(gx.pixels.data());
+    }
+    setCounters(state, w, h, 1 + 1);
+}
+
+void BM_SobelY(benchmark::State& state) {
+    const unsigned int w = state.range(0), h = state.range(1);
+    ScopedSimdLevel simd(state.range(2));
+    const ImageData& grey = syntheticGrey(w, h);
+    for (auto _ : state) {
+        ImageData gy = CustomImageFilter::sobelY(grey);
+        benchmark::DoNotOptimize(gy.pixels.data());
+    }
+    setCounters(state, w, h, 1 + 1);
+}
+
+void BM_Sobel(benchmark::State& state) {
+    const unsigned int w = state.range(0), h = state.range(1);
+    ScopedSimdLevel simd(state.range(2));
+    const ImageData& grey = syntheticGrey(w, h);
+    ImageData energy;
+    for (auto _ : state) {
+        CustomImageFilter::sobel(grey, energy);
+        benchmark::DoNotOptimize(energy.pixels.data());
+    }
+    setCounters(state, w, h, 1 + 1);
+}
+
+void BM_MinimalEnergyPathMap(benchmark::State& state) {
+    const unsigned int w = state.range(0), h = state.range(1);
+    ScopedSimdLevel simd(state.range(2));
+    const ImageData& energy = syntheticEnergy(w, h);
+    ThreadPool pool(1); // single threaded, comparable across machines
+    for (auto _ : state) {
+        std::vector<unsigned int> map = CustomImageFilter::computeMinimalEnergyPathMap(energy, pool);
+        benchmark::DoNotOptimize(map.data());
+    }
+    // energy in, previous row + output as uint32
+    setCounters(state, w, h, 1 + 4 + 4);
+}
+
+// 16 vs 32 bit cost maps on maps short enough for both (coarse pyramid levels, thumbnails)
+void shortImageSizesAndCost(benchmark::internal::Benchmark* b) {
+    for (int w : {480, 960, 1920, 3840}) {
+        for (int bits : {16, 32}) b->Args({w, 256, bits});
+    }
+}
+
+void BM_MinimalEnergyPathMapCost(benchmark::State& state) {
+    const unsigned int w = state.range(0), h = state.range(1);
+    const bool compact = state.range(2) == 16;
+    const ImageData& energy = syntheticEnergy(w, h);
+    ThreadPool pool(1);
+    for (auto _ : state) {
+        if (compact) benchmark::DoNotOptimize(CustomImageFilter::computeCostMap<uint16_t>(energy, pool).data());
+        else benchmark::DoNotOptimize(CustomImageFilter::computeCostMap<unsigned int>(energy, pool).data());
+    }
+    const double costBytes = compact ? 2 : 4;
+    setCounters(state, w, h, 1 + 2 * costBytes);
+}
+
+void BM_MinimalEnergyPathMapParallel(benchmark::State& state) {
+    const unsigned int w = state.range(0), h = state.range(1);
+    const ImageData& energy = syntheticEnergy(w, h);
+    for (auto _ : state) {
+        std::vector<unsigned int> map = CustomImageFilter::computeMinimalEnergyPathMap(energy);
+        benchmark::DoNotOptimize(map.data());
+    }
+    setCounters(state, w, h, 1 + 4 + 4);
+    state.counters["threads"] = ThreadPool::shared().getThreadCount();
+}
+
+// Fused forward energy DP straight from the greyscale image (replaces Sobel + DP)
+void BM_ForwardEnergyPathMap(benchmark::State& state) {
+    const unsigned int w = state.range(0), h = state.range(1);
+    const ImageData& grey = syntheticGrey(w, h);
+    ThreadPool pool(1);
+    for (auto _ : state) {
+        std::vector<unsigned int> map = CustomImageFilter::computeForwardEnergyPathMap(grey, pool);
+        benchmark::DoNotOptimize(map.data());
+    }
+    // two greyscale rows in, previous row + output as uint32
+    setCounters(state, w, h, 1 + 4 + 4);
+}
+
+void BM_IdentityMinEnergySeam(benchmark::State& state) {
+    const unsigned int w = state.range(0), h = state.range(1);
+    const std::vector<unsigned int> map = CustomImageFilter::computeMinimalEnergyPathMap(syntheticEnergy(w, h));
+    for (auto _ : state) {
+        std::vector<unsigned int> seam = CustomImageFilter::identityMinEnergySeam(map, w, h);
+        benchmark::DoNotOptimize(seam.data());
+    }
+    // Touches the last row fully, then 3 entries per row
+    state.SetItemsProcessed(state.iterations() * h);
+    state.counters["bytes_per_pixel"] = (4.0 * w + 12.0 * h) / (static_cast<double>(w) * h);
+}
+
+// DP with the step plane, then the O(h) trace (compare with the two benchmarks above)
+void BM_MinimalEnergyPathMapDirections(benchmark::State& state) {
+    const unsigned int w = state.range(0), h = state.range(1);
+    const ImageData& energy = syntheticEnergy(w, h);
+    ThreadPool pool(1);
+    std::vector<int8_t> directions;
+    for (auto _ : state) {
+        std::vector<unsigned int> map = CustomImageFilter::computeMinimalEnergyPathMap(energy, directions, pool);
+        benchmark::DoNotOptimize(map.data());
+    }
+    // energy in, previous row + output as uint32, one step byte out
+    setCounters(state, w, h, 1 + 4 + 4 + 1);
+}
+
+void BM_TraceSeamColumns(benchmark::State& state) {
+    const unsigned int w = state.range(0), h = state.range(1);
+    std::vector<int8_t> directions;
+    const std::vector<unsigned int> map = CustomImageFilter::computeMinimalEnergyPathMap(syntheticEnergy(w, h), directions, ThreadPool::shared());
+    for (auto _ : state) {
+        std::vector<unsigned int> columns = CustomImageFilter::identityMinEnergySeamColumns(map, directions, w, h);
+        benchmark::DoNotOptimize(columns.data());
+    }
+    // Last row fully, then one step byte per row
+    state.SetItemsProcessed(state.iterations() * h);
+}
+
+void BM_RemoveSeam(benchmark::State& state) {
+    const unsigned int w = state.range(0), h = state.range(1);
+    const ImageData& source = syntheticImage(w, h, 3);
+    const std::vector<unsigned int> seam = CustomImageFilter::identityMinEnergySeam(
+        CustomImageFilter::computeMinimalEnergyPathMap(syntheticEnergy(w, h)), w, h);
+    ImageData image = source;
+    for (auto _ : state) {
+        state.PauseTiming();
+        image = source;
+        state.ResumeTiming();
+        CustomImageFilter::removeSeam(image, seam);
+        benchmark::DoNotOptimize(image.pixels.data());
+    }
+    setCounters(state, w, h, 3 + 3);
+}
+
+// Cache-blocked transpose used for horizontal seams
+void BM_Transpose(benchmark::State& state) {
+    const unsigned int w = state.range(0), h = state.range(1);
+    const ImageData& image = syntheticImage(w, h, 3);
+    for (auto _ : state) {
+        ImageData transposed = CustomImageFilter::transpose(image);
+        benchmark::DoNotOptimize(transposed.pixels.data());
+    }
+    setCounters(state, w, h, 3 + 3);
+}
+
+// Primitive resize to 75% of both axes (the fallback for seam carving), RGB
+void BM_Resize(benchmark::State& state) {
+    const unsigned int w = state.range(0), h = state.range(1);
+    ScopedSimdLevel simd(state.range(2));
+    const ResampleFilter filter = static_cast<ResampleFilter>(state.range(3));
+    const ImageData& image = syntheticImage(w, h, 3);
+    for (auto _ : state) {
+        ImageData resized = CustomImageFilter::resize(image, w * 3 / 4, h * 3 / 4, filter);
+        benchmark::DoNotOptimize(resized.pixels.data());
+    }
+    setCounters(state, w, h, 3 + 3);
+}
+
+constexpr unsigned int kCarveSeams = 8;
+
+// The carve loop as it was before any optimization (float greyscale, two branchy 3x3
+// convolutions, scalar DP, backtrack, one vector::erase per seam pixel), reproduced here
+// as the reference the optimized stages are measured against
+namespace baseline {
+
+ImageData convolution(const ImageData& input, const int* kernel) {
+    const int width = static_cast<int>(input.getWidth()), height = static_cast<int>(input.getHeight());
+    ImageData output(width, height, 1);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            int sum = 0;
+            for (int ky = -1; ky <= 1; ++ky) {
+                for (int kx = -1; kx <= 1; ++kx) {
+                    int posX = x + kx, posY = y + ky;
+                    if (posX < 0 || posX >= width) posX = x - kx; // mirror at the border
+                    if (posY < 0 || posY >= height) posY = y - ky;
+                    sum += input.pixels[posY * width + posX] * kernel[(ky + 1) * 3 + (kx + 1)];
+                }
+            }
+            output.pixels[y * width + x] = static_cast<unsigned char>(std::clamp(std::abs(sum), 0, 255));
+        }
+    }
+    return output;
+}
+
+ImageData energy(const ImageData& image) {
+    ImageData grey(image.getWidth(), image.getHeight(), 1);
+    auto in = image.pixels.begin();
+    for (auto out = grey.pixels.begin(); out != grey.pixels.end(); ++out, in += image.getChannels()) {
+        *out = static_cast<unsigned char>(0.299f * in[0] + 0.587f * in[1] + 0.114f * in[2]);
+    }
+    static const int gx[9] = {-1, 0, 1, -2, 0, 2, -1, 0, 1};
+    static const int gy[9] = {-1, -2, -1, 0, 0, 0, 1, 2, 1};
+    const ImageData dx = convolution(grey, gx), dy = convolution(grey, gy);
+    for (size_t i = 0; i < grey.pixels.size(); ++i) {
+        const int magnitude = static_cast<int>(std::sqrt(dx.pixels[i] * dx.pixels[i] + dy.pixels[i] * dy.pixels[i]));
+        grey.pixels[i] = static_cast<unsigned char>(std::clamp(magnitude, 0, 255));
+    }
+    return grey;
+}
+
+std::vector<unsigned int> pathMap(const ImageData& energy) {
+    const int width = static_cast<int>(energy.getWidth()), height = static_cast<int>(energy.getHeight());
+    std::vector<unsigned int> map(energy.pixels.begin(), energy.pixels.end());
+    for (int y = 1; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            const unsigned int above = (y - 1) * width + x;
+            unsigned int best = map[above];
+            if (x - 1 >= 0) best = std::min(best, map[above - 1]);
+            if (x + 1 < width) best = std::min(best, map[above + 1]);
+            map[y * width + x] += best;
+        }
+    }
+    return map;
+}
+
+// Bottom to top, so erasing pixel by pixel never shifts a pixel still to be erased
+std::vector<unsigned int> seam(const std::vector<unsigned int>& map, int width, int height) {
+    std::vector<unsigned int> pixels;
+    int x = static_cast<int>(std::min_element(map.end() - width, map.end()) - (map.end() - width));
+    pixels.push_back((height - 1) * width + x);
+    for (int y = height - 1; y > 0; --y) {
+        const unsigned int above = (y - 1) * width + x;
+        unsigned int best = map[above];
+        int step = 0;
+        if (x - 1 >= 0 && map[above - 1] < best) { best = map[above - 1]; step = -1; }
+        if (x + 1 < width && map[above + 1] < best) step = 1;
+        x += step;
+        pixels.push_back((y - 1) * width + x);
+    }
+    return pixels;
+}
+
+void removeSeam(ImageData& image, const std::vector<unsigned int>& seam) {
+    const unsigned int channels = image.getChannels();
+    for (auto pixel : seam) image.pixels.erase(image.pixels.begin() + pixel * channels, image.pixels.begin() + (pixel + 1) * channels);
+    // setWidth() would resize the already shrunk buffer back, so rebuild the image around it
+    ImageData carved(image.getWidth() - 1, image.getHeight(), channels);
+    carved.pixels = std::move(image.pixels);
+    image = std::move(carved);
+}
+
+} // namespace baseline
+
+// The original loop (see 'baseline'): quadratic seam removal, so only up to 1024^2
+void BM_BaselineCarveLoop(benchmark::State& state) {
+    const unsigned int w = state.range(0), h = state.range(1);
+    const ImageData& source = syntheticImage(w, h, 3);
+    for (auto _ : state) {
+        ImageData image = source;
+        for (unsigned int s = 0; s < kCarveSeams; ++s) {
+            const std::vector<unsigned int> map = baseline::pathMap(baseline::energy(image));
+            baseline::removeSeam(image, baseline::seam(map, static_cast<int>(image.getWidth()), static_cast<int>(h)));
+        }
+        benchmark::DoNotOptimize(image.pixels.data());
+    }
+    state.SetItemsProcessed(state.iterations() * kCarveSeams * static_cast<int64_t>(w) * h);
+    state.counters["seams_per_second"] = benchmark::Counter(static_cast<double>(state.iterations() * kCarveSeams), benchmark::Counter::kIsRate);
+}
+
+// Stateless loop on the current kernels: greyscale, Sobel, DP, backtrack and removal
+// recomputed from scratch for every seam
+void BM_StatelessCarveLoop(benchmark::State& state) {
+    const unsigned int w = state.range(0), h = state.range(1);
+    const ImageData& source = syntheticImage(w, h, 3);
+    for (auto _ : state) {
+        ImageData image = source;
+        for (unsigned int s = 0; s < kCarveSeams; ++s) {
+            ImageData energy = CustomImageFilter::sobel(CustomImageFilter::toGreyscale(image));
+            std::vector<unsigned int> map = CustomImageFilter::computeMinimalEnergyPathMap(energy);
+            CustomImageFilter::removeSeam(image, CustomImageFilter::identityMinEnergySeam(map, image.getWidth(), h));
+        }
+        benchmark::DoNotOptimize(image.pixels.data());
+    }
+    // items = pixels processed per removed seam
+    state.SetItemsProcessed(state.iterations() * kCarveSeams * static_cast<int64_t>(w) * h);
+    state.counters["seams_per_second"] = benchmark::Counter(static_cast<double>(state.iterations() * kCarveSeams), benchmark::Counter::kIsRate);
+}
+
+// Incremental carving (SeamCarver: energy only updated around removed seams), including setup
+void BM_SeamCarverStep(benchmark::State& state) {
+    const unsigned int w = state.range(0), h = state.range(1);
+    const ImageData& source = syntheticImage(w, h, 3);
+    for (auto _ : state) {
+        SeamCarver carver(source);
+        for (unsigned int s = 0; s < kCarveSeams; ++s) carver.carveStep(0);
+        benchmark::DoNotOptimize(carver.getRemovedSeams());
+    }
+    state.SetItemsProcessed(state.iterations() * kCarveSeams * static_cast<int64_t>(w) * h);
+    state.counters["seams_per_second"] = benchmark::Counter(static_cast<double>(state.iterations() * kCarveSeams), benchmark::Counter::kIsRate);
+}
+
+// Same with coarse-to-fine seams (range 2 = pyramid levels)
+void BM_SeamCarverStepPyramid(benchmark::State& state) {
+    const unsigned int w = state.range(0), h = state.range(1);
+    const ImageData& source = syntheticImage(w, h, 3);
+    SeamCarveOptions options;
+    options.pyramidLevels = static_cast<unsigned int>(state.range(2));
+    for (auto _ : state) {
+        SeamCarver carver(source, options);
+        for (unsigned int s = 0; s < kCarveSeams; ++s) carver.carveStep(0);
+        benchmark::DoNotOptimize(carver.getRemovedSeams());
+    }
+    state.SetItemsProcessed(state.iterations() * kCarveSeams * static_cast<int64_t>(w) * h);
+    state.counters["seams_per_second"] = benchmark::Counter(static_cast<double>(state.iterations() * kCarveSeams), benchmark::Counter::kIsRate);
+}
+
+void BM_ApplySeamOrder(benchmark::State& state) {
+    const unsigned int w = state.range(0), h = state.range(1);
+    const ImageData& source = syntheticImage(w, h, 3);
+    // Order of a fully carved image is too slow to build at 8K: random per-row permutations
+    // (same memory traffic, worst case for branch prediction)
+    std::vector<unsigned int> order(static_cast<size_t>(w) * h);
+    std::mt19937 rng(7);
+    for (unsigned int y = 0; y < h; ++y) {
+        auto row = order.begin() + static_cast<size_t>(y) * w;
+        std::iota(row, row + w, 0u);
+        std::shuffle(row, row + w, rng);
+    }
+    for (auto _ : state) {
+        ImageData carved = CustomImageFilter::applySeamOrder(source, order.data(), w / 2);
+        benchmark::DoNotOptimize(carved.pixels.data());
+    }
+    setCounters(state, w, h, 4 + 3 + 1.5);
+}
+
+// Enlarge to 150% (w / 2 inserted seams, thousands at 4K / 8K) in one pass
+void BM_ApplySeamInsertion(benchmark::State& state) {
+    const unsigned int w = state.range(0), h = state.range(1);
+    const ImageData& source = syntheticImage(w, h, 3);
+    std::vector<unsigned int> order(static_cast<size_t>(w) * h);
+    std::mt19937 rng(7);
+    for (unsigned int y = 0; y < h; ++y) {
+        auto row = order.begin() + static_cast<size_t>(y) * w;
+        std::iota(row, row + w, 0u);
+        std::shuffle(row, row + w, rng);
+    }
+    for (auto _ : state) {
+        ImageData enlarged = CustomImageFilter::applySeamInsertion(source, order.data(), w + w / 2);
+        benchmark::DoNotOptimize(enlarged.pixels.data());
+    }
+    setCounters(state, w, h, 4 + 3 + 4.5);
+}
+
+} // namespace
+
+BENCHMARK(BM_ToGreyscale)->Apply(imageSizesAndSimd)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_SobelX)->Apply(imageSizesAndSimd)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_SobelY)->Apply(imageSizesAndSimd)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_Sobel)->Apply(imageSizesAndSimd)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_MinimalEnergyPathMap)->Apply(imageSizesAndSimd)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_MinimalEnergyPathMapCost)->Apply(shortImageSizesAndCost)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_MinimalEnergyPathMapParallel)->Apply(imageSizes)->Unit(benchmark::kMicrosecond)->UseRealTime();
+BENCHMARK(BM_ForwardEnergyPathMap)->Apply(imageSizes)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_IdentityMinEnergySeam)->Apply(imageSizes)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_MinimalEnergyPathMapDirections)->Apply(imageSizes)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_TraceSeamColumns)->Apply(imageSizes)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_RemoveSeam)->Apply(imageSizes)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_Transpose)->Apply(imageSizes)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_Resize)->Apply(imageSizesSimdAndFilter)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_BaselineCarveLoop)->Apply(smallImageSizes)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_StatelessCarveLoop)->Apply(imageSizes)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_SeamCarverStep)->Apply(imageSizes)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_SeamCarverStepPyramid)->Apply(largeImageSizesAndPyramid)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ApplySeamOrder)->Apply(imageSizes)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_ApplySeamInsertion)->Apply(imageSizes)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
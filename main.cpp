@@ -11,100 +11,183 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
+#include <chrono>
 #include <string>
 #include <random>
-#include <thread>
-#include <atomic>
 #include <mutex>
-#include <condition_variable>
 #include <cmath>
 #include <cfloat>
+#include <algorithm>
+#include <fstream>
 
 #include "ImageData.h"
 #include "CustomImageFilter.h"
+#include "GLTextureCache.h"
+#include "CarveJobScheduler.h"
+#include "CarveStats.h"
+#include "SeamCarver.h"
+#include "SeamIndexFile.h"
 #include "SobelShader.h"
+#include "TripleBuffer.h"
+
+// Seam carving settings of one preview request (copied into the job that serves it)
+struct PreviewRequest {
+	unsigned int target_image_width = 0;
+	unsigned int target_image_height = 0;
+	unsigned int min_image_width = 1; // narrowest width the slider can ask for
+	float seam_batch_fraction = 0.0f; // share of the remaining seams removed per DP pass (0 = one seam, exact)
+	bool forward_energy = false; // forward instead of backward (Sobel) energy
+	unsigned int pyramid_levels = 0; // coarse-to-fine seam search (0 = full resolution DP)
+	bool transport_map = false; // transport map seam order when both dimensions shrink
+};
+
+// Seam removal order index of the base image, kept across preview jobs
+struct SeamIndexCache {
+	std::mutex mtx; // held by the job using it
+	SeamIndexFile index_file;                 // mapped index from disk
+	std::vector<unsigned int> computed_order; // index computed in this process
+	const unsigned int *removal_order = nullptr;
+	float batch = 0.0f;       // seam batch setting the index was built with
+	bool forward = false;     // energy mode the index was built with
+	unsigned int pyramid = 0; // pyramid levels the index was built with
+	CarveStats stats; // per-stage timings of the last index build, readable lock-free from the UI
+};
 
-// Seam carving background job state + worker (extracted from main)
-struct SeamCarveJobState {
-	std::atomic<unsigned int> target_image_width{0};
-	std::atomic<bool> compute_request{false};
-	std::atomic<bool> is_busy{false};
-	std::atomic<bool> result_available{false};
-	std::atomic<bool> stop_request{false};
-	std::atomic<unsigned int> progress_percent{100}; // 0..100 progress of current task
-	std::mutex mtx; // protects result and sobel_result
-	std::condition_variable cv;
-	ImageData result;
-	ImageData sobel_result;
+// Carved preview + its Sobel energy, handed to the render loop through a TripleBuffer
+struct PreviewFrame {
+	ImageData image;
+	ImageData sobel; // empty for partial results of an index build
 };
 
-// Worker thread entry point.
-// Repeatedly waits for a carving request, then performs:
-//  1. Reset working copy and compute initial greyscale.
-//  2. Iteratively compute energy (Sobel), DP minimal energy map, seam, and remove it.
-//  3. Adapts to slider changes mid-process by re-reading target width.
-//  4. Publishes the final carved image + last Sobel energy when target reached.
+// Partial results of an index build are published at most this often, and never more
+// than 1/kSnapshotCostRatio of the build goes into them: each copies the live columns of
+// the colour image on the carving thread (about 4 ms for a full 4K image, less as it
+// narrows), slow machines just get fewer frames.
+static constexpr std::chrono::milliseconds kSnapshotInterval{100};
+static constexpr int kSnapshotCostRatio = 50;
+// A preview that has not published anything after this long (e.g. while the index is
+// built) shows the primitive resize instead until carved frames arrive
+static constexpr std::chrono::milliseconds kCarveLatencyBudget{250};
+
+// Job submitted to the scheduler for every preview request. Newer requests supersede it.
+//  1. On the first request (or when the seam batch / energy / pyramid setting changed) loads the seam
+//     removal order index from 'index_path' (memory-mapped) if it was built from this
+//     image with the same settings. Otherwise carves the base image down to the minimal
+//     width once, recording for every pixel after how many seams it was removed, and
+//     writes the index for the next start. Progress is reported meanwhile, and the
+//     partially carved image (colour only) is published every kSnapshotInterval while it
+//     is still wider than the request (exactly the answer once the build passes the
+//     target width).
+//  2. Answers the request with a single filter pass over the base image, keeping the
+//     pixels that survive (width - target) seams. A smaller target height then removes
+//     horizontal seams (vertical seams of the transposed image), or, with the transport
+//     map enabled, both dimensions are carved together in the transport map order
+//     (width first when its table would be too large for the image).
+//  3. Publishes the carved image + its Sobel energy to 'frames' (moved, never copied;
+//     the energy reuses the buffer of a frame the render loop is done with).
 // Notes:
-//  - Starts from the original image each request (stateless approach keeps logic simple).
-//  - Thread-safe publication guarded by mutex; atomics signal availability/state.
-static void seamCarveWorker(const ImageData &base_image, SeamCarveJobState &job) {
-	while (!job.stop_request.load()) {
-		// 1. Wait until there's a new request (or stop signaled)
-		std::unique_lock<std::mutex> lk(job.mtx);
-		job.cv.wait(lk, [&]() { return job.compute_request.load() || job.stop_request.load(); });
-		if (job.stop_request.load()) break; // graceful shutdown
-
-		// Capture current target & transition to working state
-		unsigned int target = job.target_image_width.load();
-		job.compute_request.store(false);
-		job.is_busy.store(true);
-
-		// Prepare working copies (fresh start each request)
-		ImageData seam_carved = base_image;
-		ImageData greyscale_image = CustomImageFilter::toGreyscale(seam_carved);
-		const unsigned int original_width = seam_carved.getWidth();
-
-		// Release lock during heavy processing (only needed for publishing results)
-		lk.unlock();
-
-		ImageData sobel_image = greyscale_image; // To prevent empty image in case of no carving
-		// 2. Seam removal loop until desired width or stop
-		while (!job.stop_request.load() && seam_carved.getWidth() > target) {
-			// If user moves the slider, adapt target without restarting
-			unsigned int latestTarget = job.target_image_width.load();
-			if (latestTarget != target) target = latestTarget;
-
-			// (a) Compute contrast image with Sobel
-			sobel_image = CustomImageFilter::sobel(greyscale_image);
-
-			// (b) Dynamic programming minimal energy path map
-			std::vector<unsigned int> minimalEnergyPathMap = CustomImageFilter::computeMinimalEnergyPathMap(sobel_image);
-
-			// (c) Extract minimal energy seam
-			std::vector<unsigned int> seam = CustomImageFilter::identityMinEnergySeam( minimalEnergyPathMap, sobel_image.getWidth(), sobel_image.getHeight());
-
-			// (d) Remove seam from working + greyscale versions
-			CustomImageFilter::removeSeam(seam_carved, seam);
-			CustomImageFilter::removeSeam(greyscale_image, seam);
-
-			// Update progress
-			if ((original_width - target) != 0) {
-				unsigned int completion_percentage = (original_width - seam_carved.getWidth()) * 100u / (original_width - target);
-				if (completion_percentage > 100u) completion_percentage = 100u;
-				job.progress_percent.store(completion_percentage);
+//  - After the index exists any width is answered instantly, moving from 60% to 55%
+//    no longer redoes the first 40% of the seams. Height reduction is carved per request
+//    and abandoned as soon as a newer request supersedes the job.
+//  - The index build only stops on 'shutdown': a superseded job finishes it, so the
+//    next request finds it ready instead of starting over.
+static bool carvePreview(const ImageData &base_image, const std::string &index_path, SeamIndexCache &cache,
+	const CancellationToken &shutdown, const PreviewRequest &request, const CarveJobContext &context,
+	TripleBuffer<PreviewFrame> &frames) {
+	std::lock_guard<std::mutex> lk(cache.mtx);
+
+	const unsigned int target = std::clamp(request.target_image_width, request.min_image_width, 2 * base_image.getWidth());
+	const unsigned int target_height = std::clamp(request.target_image_height, 1u, base_image.getHeight());
+
+	// 1. Load or build the seam removal order index if needed
+	SeamCarveOptions options;
+	options.seamBatchFraction = request.seam_batch_fraction;
+	options.energyMode = request.forward_energy ? EnergyMode::Forward : EnergyMode::Backward;
+	options.pyramidLevels = request.pyramid_levels;
+	if (cache.removal_order == nullptr || request.seam_batch_fraction != cache.batch || request.forward_energy != cache.forward ||
+		request.pyramid_levels != cache.pyramid) {
+		options.stats = &cache.stats;
+		if (cache.index_file.open(index_path) && cache.index_file.matches(base_image, request.min_image_width, options)) {
+			cache.removal_order = cache.index_file.getRemovalOrder();
+		} else {
+			cache.removal_order = nullptr;
+			cache.index_file = SeamIndexFile(); // unmap before the file gets replaced
+			cache.stats.reset();
+			auto next_snapshot = std::chrono::steady_clock::now() + kSnapshotInterval;
+			bool target_shown = false;
+			auto snapshot = [&](const SeamCarver &carver) {
+				// Nothing to show once superseded or narrower than the request
+				if (target_shown || carver.getWidth() < target || context.token.isCancelled()) return;
+				const auto now = std::chrono::steady_clock::now();
+				target_shown = carver.getWidth() == target;
+				if (!target_shown && now < next_snapshot) return;
+				// Runs on the carving thread: only the live columns of the colour image are copied,
+				// packed into the buffer of the slot the render loop gave back (no allocation once
+				// it is large enough). No energy view, the render loop shows it for final frames.
+				PreviewFrame &frame = frames.writeBuffer();
+				const ImageData &carved = carver.getImage();
+				if (frame.image.getLayout() != RowLayout::Packed || frame.image.getHeight() != carved.getHeight() ||
+					frame.image.getChannels() != carved.getChannels()) {
+					frame.image = ImageData(carved.getWidth(), carved.getHeight(), carved.getChannels());
+				} else {
+					frame.image.setWidth(carved.getWidth());
+				}
+				frame.image.copyRowsFrom(carved.view());
+				frame.sobel = ImageData();
+				frames.publish();
+				const auto copy_time = std::chrono::steady_clock::now() - now;
+				next_snapshot = now + std::max<std::chrono::steady_clock::duration>(kSnapshotInterval, copy_time * kSnapshotCostRatio);
+			};
+			cache.computed_order = SeamCarver::computeRemovalOrder(base_image, request.min_image_width, options,
+				[&](unsigned int removed, unsigned int total) {
+					context.status.progressPercent.store(total != 0 ? removed * 100u / total : 100u);
+					return !shutdown.isCancelled();
+				}, snapshot);
+			if (cache.computed_order.empty()) return false; // cancelled by shutdown
+			SeamIndexFile::write(index_path, base_image, cache.computed_order, request.min_image_width, options);
+			cache.removal_order = cache.computed_order.data();
+		}
+		cache.batch = request.seam_batch_fraction;
+		cache.forward = request.forward_energy;
+		cache.pyramid = request.pyramid_levels;
+		options.stats = nullptr;
+	}
+	if (context.token.isCancelled()) return false; // a newer request is waiting
+
+	// 2. Any width is now a single pass over the base image
+	// Height carving and large enlargements are not indexed: give up when superseded
+	const SeamCarver::ProgressCallback height_progress = context.progress();
+	ImageData seam_carved;
+	if (target_height < base_image.getHeight() && request.transport_map) {
+		seam_carved = SeamCarver::retarget(base_image, target, target_height, options, RetargetOrder::TransportMap, height_progress);
+	} else {
+		bool height_carved = false;
+		if (target <= base_image.getWidth()) {
+			seam_carved = CustomImageFilter::applySeamOrder(base_image, cache.removal_order, target);
+		} else if (target - base_image.getWidth() <= base_image.getWidth() - request.min_image_width) {
+			// The index also holds the lowest seams to duplicate: still a single pass
+			seam_carved = CustomImageFilter::applySeamInsertion(base_image, cache.removal_order, target);
+		} else {
+			// Widened then shortened: each pass reports half of the progress range
+			const unsigned int passes = target_height < base_image.getHeight() ? 2 : 1;
+			seam_carved = SeamCarver::insertSeams(base_image, target, options, progressSlice(height_progress, 0, passes));
+			if (seam_carved.getWidth() != 0 && passes == 2) {
+				seam_carved = SeamCarver::carveHeight(seam_carved, target_height, options, progressSlice(height_progress, 1, passes));
 			}
+			height_carved = true;
+		}
+		if (!height_carved && seam_carved.getWidth() != 0 && target_height < base_image.getHeight()) {
+			seam_carved = SeamCarver::carveHeight(seam_carved, target_height, options, height_progress);
 		}
-
-		// Publish result (lock to prevent race conditions)
-		std::lock_guard<std::mutex> lk2(job.mtx);
-		job.result       = seam_carved;
-		job.sobel_result = sobel_image;
-		job.result_available.store(true);
-		job.progress_percent.store(100);
-		
-		// Mark worker idle after finishing current request
-		job.is_busy.store(false);
 	}
+	if (seam_carved.getWidth() == 0 || context.token.isCancelled()) return false; // superseded (or stopped)
+
+	// 3. Publish (jobs run one at a time under cache.mtx: single producer)
+	PreviewFrame &frame = frames.writeBuffer();
+	CustomImageFilter::sobel(CustomImageFilter::toGreyscale(seam_carved), frame.sobel);
+	frame.image = std::move(seam_carved);
+	frames.publish();
+	return true;
 }
 
 // Draw some int value as text in the center of image
@@ -122,6 +205,44 @@ static void DrawTextOverlay(const ImVec2& image_pos, const ImVec2& image_size, u
 	draw_list->AddText(font, big_size, text_pos, color, value_text.c_str());
 }
 
+// Per-stage timings of the seam carving worker, plus JSON / Chrome trace export
+static void DrawCarveStats(const CarveStats &stats) {
+	if (!ImGui::CollapsingHeader("Carve Stats")) return;
+
+	const CarveStatsSnapshot snapshot = stats.snapshot();
+	ImGui::Text("%llu seams, %.1f seams/s, %.1f MB allocated", static_cast<unsigned long long>(snapshot.seams),
+		snapshot.seamsPerSecond(), snapshot.bytesAllocated / (1024.0 * 1024.0));
+	if (ImGui::BeginTable("carve_stats", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+		ImGui::TableSetupColumn("Stage");
+		ImGui::TableSetupColumn("Count");
+		ImGui::TableSetupColumn("Total ms");
+		ImGui::TableSetupColumn("Mean us");
+		ImGui::TableSetupColumn("Max us");
+		ImGui::TableHeadersRow();
+		for (size_t i = 0; i < snapshot.stages.size(); ++i) {
+			const CarveStatsSnapshot::Stage &stage = snapshot.stages[i];
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn(); ImGui::TextUnformatted(carveStageName(static_cast<CarveStage>(i)));
+			ImGui::TableNextColumn(); ImGui::Text("%llu", static_cast<unsigned long long>(stage.count));
+			ImGui::TableNextColumn(); ImGui::Text("%.1f", stage.totalNs / 1e6);
+			ImGui::TableNextColumn(); ImGui::Text("%.1f", stage.count ? stage.totalNs / 1e3 / stage.count : 0.0);
+			ImGui::TableNextColumn(); ImGui::Text("%.1f", stage.maxNs / 1e3);
+		}
+		ImGui::EndTable();
+	}
+
+	// Written to the working directory
+	auto save = [](const char *path, const std::string &content) {
+		std::ofstream out(path, std::ios::trunc);
+		out << content;
+		if (out) spdlog::info("Wrote {}", path);
+		else spdlog::error("Failed to write {}", path);
+	};
+	if (ImGui::Button("Save JSON")) save("carve_stats.json", stats.toJson());
+	ImGui::SameLine();
+	if (ImGui::Button("Save Chrome Trace")) save("carve_trace.json", stats.toChromeTrace());
+}
+
 // load image
 unsigned char *load_image(const std::string &path, int &width, int &height,
 													int &channels) {
@@ -133,23 +254,6 @@ unsigned char *load_image(const std::string &path, int &width, int &height,
 	return pixels;
 }
 
-void load_ImageData_to_GLTexture(const ImageData &image, GLuint texture_id) {
-	if (image.pixels.empty()) {
-		spdlog::error("ImageData has no pixel data.");
-		return;
-	}
-
-	GLenum format = image.getGLFormat();
-	if (format == 0) {
-		spdlog::error("Unsupported number of channels: {}", image.getChannels());
-		return;
-	}
-
-	glBindTexture(GL_TEXTURE_2D, texture_id);
-	glTexImage2D(GL_TEXTURE_2D, 0, format, image.getWidth(), image.getHeight(), 0,
-				 format, GL_UNSIGNED_BYTE, image.pixels.data());
-}
-
 int main(int, char **) {
 	// Setup window
 	if (!glfwInit())
@@ -220,43 +324,13 @@ int main(int, char **) {
 	ImVec4 clear_color = ImVec4(0.168f, 0.394f, 0.534f, 1.00f);
 
 
-	// Setup texture for displaying base image
-	GLuint original_image_text_id;
-	glGenTextures(1, &original_image_text_id);
-	glBindTexture(GL_TEXTURE_2D, original_image_text_id);
-	// Setup filtering parameters for display
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-	// Setup texture for displaying seam carved image
-	GLuint seam_carved_image_id;
-	glGenTextures(1, &seam_carved_image_id);
-	glBindTexture(GL_TEXTURE_2D, seam_carved_image_id);
-	// Filtering parameters for display
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	// Set alignment to 1 byte (for width not multiple of 4). Prevents jumbling
-	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-
-	// Setup texture for displaying primitive resized image
-	GLuint primitive_resized_image_id;
-	glGenTextures(1, &primitive_resized_image_id);
-	glBindTexture(GL_TEXTURE_2D, primitive_resized_image_id);
-	// Setup filtering parameters for display
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	// Set alignment to 1 byte (for width not multiple of 4). Prevents jumbling
-	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-
-	// Setup texture for displaying debug (e.g. Sobel) image
-	GLuint debug_tex;
-	glGenTextures(1, &debug_tex);
-	glBindTexture(GL_TEXTURE_2D, debug_tex);
-	// Setup filtering parameters for display
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	// Set alignment to 1 byte (for width not multiple of 4). Prevents jumbling
-	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	// Display textures, re-uploaded only when the shown image changed. The carved image
+	// is written into storage sized for the largest result, so it never reallocates.
+	// Async (PBO) uploads for the images that change while carving.
+	GLTextureCache original_texture;
+	GLTextureCache seam_carved_texture(/*asyncUpload=*/true);
+	GLTextureCache primitive_resized_texture;
+	GLTextureCache debug_texture(/*asyncUpload=*/true);
 
 	// Load image from file
 	// ----- START HERE -----
@@ -277,20 +351,47 @@ int main(int, char **) {
 
 
 	// Create a copy of the image pixels for processing
-	ImageData primitive_resized_image = base_image; // for now just copy original
-	// Initialize seam carved image
-	ImageData seam_carved_image = base_image; // for now just copy original
-	ImageData sobel_image = base_image; // energy visualization
+	// Plain resize to the same target, as comparison and as fallback for slow carves
+	ImageData primitive_resized_image = base_image;
+	// Seam carved image + energy view, published by the carving jobs (initially the original)
+	TripleBuffer<PreviewFrame> preview_frames;
+	preview_frames.readBuffer().image = base_image;
+	preview_frames.readBuffer().sobel = base_image;
+	// Seam insertion widens up to 2x
+	seam_carved_texture.reserve(2 * base_image.getWidth(), base_image.getHeight(), base_image.getChannels());
+	debug_texture.reserve(2 * base_image.getWidth(), base_image.getHeight(), 1);
 
 	// Background job state for seam carving
-	SeamCarveJobState job;
-
-	job.result = base_image;
-	job.sobel_result = sobel_image;
-	job.target_image_width = base_image.getWidth();
-
-	// Launch worker thread
-	std::thread worker(seamCarveWorker, std::cref(base_image), std::ref(job));
+	PreviewRequest request;
+	request.target_image_width = base_image.getWidth();
+	request.target_image_height = base_image.getHeight();
+	// Matches the 10% lower bound of the scale slider
+	request.min_image_width = std::max(1u, static_cast<unsigned int>(base_image.getWidth() * 0.10f));
+
+	// Seam removal order index is cached next to the image
+	const std::string index_path = img_path + ".seamidx";
+	SeamIndexCache index_cache;
+	CancellationToken shutdown;
+	// One preview job at a time (its parallel stages use the shared thread pool); each
+	// request supersedes the previous one, so the UI never waits for a stale result
+	CarveJobScheduler scheduler(1);
+	const uint64_t preview_group = 1;
+	CarveJobHandle preview_job;
+	// The primitive resize gets a thread of its own: it never waits for an index build,
+	// and the UI thread never helps with (or waits for) a parallel loop
+	CarveJobScheduler resize_scheduler(1);
+	const uint64_t resize_group = 2;
+	CarveJobHandle resize_job;
+	std::chrono::steady_clock::time_point preview_submitted;
+	bool preview_published = true; // a frame arrived since the last submit
+	auto submit_preview = [&]() {
+		preview_submitted = std::chrono::steady_clock::now();
+		preview_published = false;
+		preview_job = scheduler.submit([&, request](const CarveJobContext &context) {
+			carvePreview(base_image, index_path, index_cache, shutdown, request, context, preview_frames);
+			return ImageData(); // the result goes through preview_frames
+		}, 0, preview_group);
+	};
 
 	int display_w, display_h;
 	// Main loop
@@ -329,9 +430,34 @@ int main(int, char **) {
 			ImGui::Text("Configure the App below.");
 			ImGui::Checkbox("Demo Window", &show_demo_window);
 			ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
-			ImGui::Text("Seam Carving: %s", job.is_busy.load() ? "Working" : "Idle");
-			ImGui::Image((ImTextureID)(intptr_t)debug_tex,
-				ImVec2(seam_carved_image.getWidth(), seam_carved_image.getHeight()));
+			ImGui::Text("Seam Carving: %s", preview_job.isPending() ? "Working" : "Idle");
+			// 0% removes one seam per energy map (best quality), higher values remove that share
+			// of the remaining seams per map (fewer passes, lower fidelity)
+			static float seam_batch_perc = 0.0f;
+			bool carve_settings_changed = ImGui::SliderFloat("Seam batch", &seam_batch_perc, 0.0f, 50.0f, "%.0f%% per pass", ImGuiSliderFlags_AlwaysClamp);
+			// Forward energy: cost of the edges a seam creates instead of the energy it removes
+			static bool forward_energy = false;
+			carve_settings_changed |= ImGui::Checkbox("Forward energy", &forward_energy);
+			// Coarse-to-fine: seams found on a 2^levels downsampled energy, refined in a narrow
+			// band at full resolution (much faster on large images, backward energy only)
+			static int pyramid_levels = 0;
+			carve_settings_changed |= ImGui::SliderInt("Pyramid levels", &pyramid_levels, 0, 4, "%d", ImGuiSliderFlags_AlwaysClamp);
+			if (carve_settings_changed) {
+				request.seam_batch_fraction = seam_batch_perc / 100.0f;
+				request.forward_energy = forward_energy;
+				request.pyramid_levels = static_cast<unsigned int>(pyramid_levels);
+				// The seam order index depends on these settings, rebuild it
+				submit_preview();
+			}
+			DrawCarveStats(index_cache.stats);
+			if (preview_frames.readBuffer().sobel.getHeight() != 0) {
+				debug_texture.update(preview_frames.readBuffer().sobel);
+				ImGui::Image((ImTextureID)(intptr_t)debug_texture.getId(),
+					ImVec2(debug_texture.getWidth(), debug_texture.getHeight()), ImVec2(0, 0),
+					ImVec2(debug_texture.getMaxU(), debug_texture.getMaxV()));
+			} else {
+				ImGui::TextUnformatted("Energy: shown once carving is done");
+			}
 			ImGui::End();
 		}
 
@@ -340,63 +466,79 @@ int main(int, char **) {
 			ImGui::Begin("Image Window");
 			// 2. upload image to gpu
 
-			// Upload pixels into texture
-			load_ImageData_to_GLTexture(base_image, original_image_text_id);
+			// Upload pixels into texture (first frame only)
+			original_texture.update(base_image);
 
 			// 3. display image
 			// (https://github.com/ocornut/imgui/wiki/Image-Loading-and-Displaying-Examples)
 			ImGui::Text("Original");
-			ImGui::Image((ImTextureID)(intptr_t)original_image_text_id, ImVec2(img_width, img_height));
+			ImGui::Image((ImTextureID)(intptr_t)original_texture.getId(), ImVec2(img_width, img_height));
 
-			// Slider to trigger an image width reduction
+			// Slider to trigger an image width reduction (or enlargement by seam insertion above 100%)
 			static float target_scale_perc = 100.0f;
-			bool slider_changed = ImGui::SliderFloat("Scale Image By", &target_scale_perc, 10.0f, 100.0f, "%.0f%%", ImGuiSliderFlags_AlwaysClamp);
+			bool slider_changed = ImGui::SliderFloat("Scale Image By", &target_scale_perc, 10.0f, 200.0f, "%.0f%%", ImGuiSliderFlags_AlwaysClamp);
 			unsigned int target_width = static_cast<unsigned int>(base_image.getWidth() * (target_scale_perc / 100.0f));
-
-			if (slider_changed) {
+			// Height reduction (horizontal seams, carved on demand)
+			static float target_height_perc = 100.0f;
+			slider_changed |= ImGui::SliderFloat("Scale Height By", &target_height_perc, 10.0f, 100.0f, "%.0f%%", ImGuiSliderFlags_AlwaysClamp);
+			unsigned int target_height = static_cast<unsigned int>(base_image.getHeight() * (target_height_perc / 100.0f));
+			// Optimal interleaving of vertical and horizontal seams, slow for large size changes
+			static bool transport_map = false;
+			slider_changed |= ImGui::Checkbox("Seam order by transport map", &transport_map);
+			static int resize_filter = static_cast<int>(ResampleFilter::Bilinear);
+			const char *resize_filters[] = {"Bilinear", "Bicubic", "Area"};
+			const bool filter_changed = ImGui::Combo("Primitive resize filter", &resize_filter, resize_filters, 3);
+
+			if (slider_changed || filter_changed) {
 				if (target_width < 1) target_width = 1;
-				// Set parameter for the Seam Carving thread
-				job.target_image_width.store(target_width);
-				// Set a compute request
-				job.compute_request.store(true);
-				job.progress_percent.store(0);
-				// Notify the thread that it can check for task to do
-				job.cv.notify_one();
+				if (target_height < 1) target_height = 1;
+				// Tens of ms for a 4K image (hundreds without SIMD): resized on its own thread,
+				// the previous result stays on screen until the new one is ready
+				const auto filter = static_cast<ResampleFilter>(resize_filter);
+				resize_job = resize_scheduler.submit([&base_image, target_width, target_height, filter](const CarveJobContext &) {
+					return CustomImageFilter::resize(base_image, target_width, target_height, filter);
+				}, 0, resize_group);
 			}
-
-			// Check if the processing thread has finished working on the picture.
-			// Pull the results if finished.
-			if (job.result_available.load()) {
-				//Require the lock to prevent race conditions.
-				std::lock_guard<std::mutex> lk(job.mtx);
-				// Copy data result
-				seam_carved_image = job.result;
-				sobel_image = job.sobel_result;
-				// Reset flag
-				job.result_available.store(false);
-				// Update debug texture
-				load_ImageData_to_GLTexture(sobel_image, debug_tex);
+			if (resize_job.ready()) {
+				ImageData resized = resize_job.get();
+				if (resized.getWidth() != 0) primitive_resized_image = std::move(resized); // empty if superseded
+			}
+			if (slider_changed) {
+				// Carve with the new parameters, superseding the running request
+				request.target_image_width = target_width;
+				request.target_image_height = target_height;
+				request.transport_map = transport_map;
+				submit_preview();
 			}
 
-			// Display seam carved image (for now just display original image)
-			// Upload pixels into texture
-			load_ImageData_to_GLTexture(seam_carved_image, seam_carved_image_id);
-			ImGui::Text("Processed (Seam Carved)");
+			// Take the latest published result, if any (never blocks, nothing is copied)
+			preview_published |= preview_frames.update();
+			// Over the latency budget without any carved frame: show the plain resize
+			const bool carve_late = !preview_published && preview_job.isPending() &&
+									std::chrono::steady_clock::now() - preview_submitted > kCarveLatencyBudget;
+			const ImageData &seam_carved_image = carve_late ? primitive_resized_image : preview_frames.readBuffer().image;
+
+			// Display seam carved image
+			// Upload pixels into texture (only when a new frame arrived)
+			seam_carved_texture.update(seam_carved_image);
+			ImGui::Text(carve_late ? "Processed (resize fallback, carving...)" : "Processed (Seam Carved)");
 			// Record position to overlay process progress if busy
 			ImVec2 image_pos = ImGui::GetCursorScreenPos();
 			ImVec2 image_size((float)seam_carved_image.getWidth(), (float)seam_carved_image.getHeight());
-			ImGui::Image((ImTextureID)(intptr_t)seam_carved_image_id, image_size);
+			ImGui::Image((ImTextureID)(intptr_t)seam_carved_texture.getId(), image_size, ImVec2(0, 0),
+						 ImVec2(seam_carved_texture.getMaxU(), seam_carved_texture.getMaxV()));
 
 
-			if (job.is_busy.load()) {
-				DrawTextOverlay(image_pos, image_size, job.progress_percent.load());
+			if (preview_job.isPending()) {
+				DrawTextOverlay(image_pos, image_size, preview_job.getProgress());
 			}
 
-			// 9. Display resized image (for now just display original image)
-			load_ImageData_to_GLTexture(primitive_resized_image, primitive_resized_image_id);
+			// 9. Display resized image
+			primitive_resized_texture.update(primitive_resized_image);
 			ImGui::Text("Primitive Resized");
-			ImGui::Image((ImTextureID)(intptr_t)primitive_resized_image_id,
-						 ImVec2(primitive_resized_image.getWidth(), primitive_resized_image.getHeight()));
+			ImGui::Image((ImTextureID)(intptr_t)primitive_resized_texture.getId(),
+						 ImVec2(primitive_resized_image.getWidth(), primitive_resized_image.getHeight()), ImVec2(0, 0),
+						 ImVec2(primitive_resized_texture.getMaxU(), primitive_resized_texture.getMaxV()));
 
 			ImGui::End();
 
@@ -427,13 +569,17 @@ int main(int, char **) {
 		glfwSwapBuffers(window);
 	}
 
-	// Signal worker to stop and join
-	job.stop_request.store(true);
-	job.cv.notify_one();
-	if (worker.joinable()) worker.join();
-
-	// Cleanup
-	// TODO glDeleteTextures(1, &image1_tex_id);
+	// Stop the running job (including an index build) and drop queued ones;
+	// the scheduler joins its thread when it goes out of scope
+	shutdown.cancel();
+	scheduler.cancelAll();
+	resize_scheduler.cancelAll();
+
+	// Cleanup (textures first, they need the GL context)
+	original_texture.release();
+	seam_carved_texture.release();
+	primitive_resized_texture.release();
+	debug_texture.release();
 	ImGui_ImplOpenGL3_Shutdown();
 	ImGui_ImplGlfw_Shutdown();
 	ImGui::DestroyContext();
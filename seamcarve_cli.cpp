@@ -0,0 +1,349 @@
+// Headless batch seam carving: no window, GL context or ImGui required.
+//
+// usage: seamcarve-cli [options] <input images...>
+//   -w, --widths <list>      comma separated target widths, absolute ("640") or relative ("50%"),
+//                            up to twice the input width (seam insertion)
+//   -t, --threads <n>        images carved at once (default 1, each carve already uses every core)
+//   -o, --output-dir <dir>   output directory (default: next to the input)
+//   -q, --queue <n>          decoded images waiting for a carving thread (default: 2 * threads)
+//   -b, --batch <fraction>   share of the remaining seams removed per DP pass (default 0 = exact)
+//   -H, --height <h>         also reduce the height of every output, absolute ("480") or relative ("75%")
+//       --transport-map      carve width and height in the transport map order (width first if too large)
+//   -f, --forward            forward energy instead of backward (Sobel) energy
+//   -p, --pyramid <levels>   coarse-to-fine seam search on a 2^levels downsampled energy (default 0 = off)
+//       --index              reuse / write <input>.seamidx seam order index files
+//
+// Each input is carved once down to its narrowest requested width (seam removal order,
+// see SeamCarver), every requested width is then a single filter pass. Wider targets
+// duplicate the first seams of that same order (CustomImageFilter::applySeamInsertion).
+// Output: <output-dir>/<stem>_w<width>.png (<stem>_w<width>_h<height>.png with --height)
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+#include "CustomImageFilter.h"
+#include "ImageData.h"
+#include "SeamCarver.h"
+#include "SeamIndexFile.h"
+
+namespace fs = std::filesystem;
+
+// Target width, either in pixels or relative to the input width
+struct TargetWidth {
+	unsigned int value = 0;
+	bool percent = false;
+
+	// 'max_scale' times the image width at most (2 for widths, 1 for heights)
+	unsigned int resolve(unsigned int image_width, unsigned int max_scale = 2) const {
+		const unsigned int w = percent ? static_cast<unsigned int>(image_width * (value / 100.0f)) : value;
+		return std::clamp(w, 1u, image_width * max_scale);
+	}
+};
+
+struct CliOptions {
+	std::vector<std::string> inputs;
+	std::vector<TargetWidth> widths;
+	std::optional<TargetWidth> height; // same parsing as widths, resolved against the image height
+	RetargetOrder order = RetargetOrder::WidthFirst;
+	unsigned int threads = 0;
+	unsigned int queue_size = 0;
+	std::string output_dir;
+	SeamCarveOptions carve;
+	bool use_index = false;
+};
+
+struct CarveJob {
+	std::string path;
+	ImageData image;
+};
+
+// Fixed capacity FIFO between the decoding thread and the carving threads.
+// push() blocks while full so at most 'capacity' decoded images wait in memory.
+class BoundedQueue {
+private:
+	std::deque<CarveJob> items;
+	size_t capacity;
+	bool closed = false;
+	std::mutex mtx;
+	std::condition_variable not_full;
+	std::condition_variable not_empty;
+
+public:
+	explicit BoundedQueue(size_t cap) : capacity(std::max<size_t>(1, cap)) {}
+
+	void push(CarveJob job) {
+		std::unique_lock<std::mutex> lk(mtx);
+		not_full.wait(lk, [&]() { return items.size() < capacity; });
+		items.push_back(std::move(job));
+		not_empty.notify_one();
+	}
+
+	// Returns std::nullopt once the queue is closed and drained
+	std::optional<CarveJob> pop() {
+		std::unique_lock<std::mutex> lk(mtx);
+		not_empty.wait(lk, [&]() { return !items.empty() || closed; });
+		if (items.empty()) return std::nullopt;
+		CarveJob job = std::move(items.front());
+		items.pop_front();
+		not_full.notify_one();
+		return job;
+	}
+
+	// No more pushes; wakes up all waiting consumers
+	void close() {
+		std::lock_guard<std::mutex> lk(mtx);
+		closed = true;
+		not_empty.notify_all();
+	}
+};
+
+static void print_usage() {
+	fmt::print(
+		"usage: seamcarve-cli [options] <input images...>\n"
+		"  -w, --widths <list>      comma separated target widths, absolute (640) or relative (50%), up to 200%\n"
+		"  -t, --threads <n>        images carved at once (default 1, each carve already uses every core)\n"
+		"  -o, --output-dir <dir>   output directory (default: next to the input)\n"
+		"  -q, --queue <n>          decoded images waiting for a carving thread (default: 2 * threads)\n"
+		"  -b, --batch <fraction>   share of the remaining seams removed per DP pass (default 0 = exact)\n"
+		"  -H, --height <h>         also reduce the height of every output, absolute (480) or relative (75%)\n"
+		"      --transport-map      carve width and height in the transport map order (width first if too large)\n"
+		"  -f, --forward            forward energy instead of backward (Sobel) energy\n"
+		"  -p, --pyramid <levels>   coarse-to-fine seam search on a 2^levels downsampled energy (default 0 = off)\n"
+		"      --index              reuse / write <input>.seamidx seam order index files\n");
+}
+
+static bool parse_widths(const std::string &list, std::vector<TargetWidth> &widths, unsigned long max_percent = 200) {
+	size_t begin = 0;
+	while (begin <= list.size()) {
+		size_t end = list.find(',', begin);
+		if (end == std::string::npos) end = list.size();
+		std::string item = list.substr(begin, end - begin);
+		TargetWidth width;
+		if (!item.empty() && item.back() == '%') {
+			width.percent = true;
+			item.pop_back();
+		}
+		char *parse_end = nullptr;
+		const unsigned long value = std::strtoul(item.c_str(), &parse_end, 10);
+		if (item.empty() || *parse_end != '\0' || value == 0 || (width.percent && value > max_percent)) {
+			spdlog::error("Invalid target width: {}", list.substr(begin, end - begin));
+			return false;
+		}
+		width.value = static_cast<unsigned int>(value);
+		widths.push_back(width);
+		begin = end + 1;
+	}
+	return true;
+}
+
+// Non-negative integer option value; anything else (e.g. "four", "4x") is an error
+static bool parse_count(const std::string &option, const char *text, unsigned int &count) {
+	char *parse_end = nullptr;
+	const unsigned long value = std::strtoul(text, &parse_end, 10);
+	if (*text < '0' || *text > '9' || *parse_end != '\0' || value > UINT_MAX) {
+		spdlog::error("Invalid value for {}: {}", option, text);
+		return false;
+	}
+	count = static_cast<unsigned int>(value);
+	return true;
+}
+
+static bool parse_args(int argc, char **argv, CliOptions &options) {
+	for (int i = 1; i < argc; ++i) {
+		const std::string arg = argv[i];
+		auto value = [&]() -> const char * { return i + 1 < argc ? argv[++i] : nullptr; };
+		if (arg == "-h" || arg == "--help") {
+			return false;
+		} else if (arg == "-w" || arg == "--widths") {
+			const char *v = value();
+			if (!v || !parse_widths(v, options.widths)) return false;
+		} else if (arg == "-t" || arg == "--threads") {
+			const char *v = value();
+			if (!v || !parse_count(arg, v, options.threads)) return false;
+		} else if (arg == "-q" || arg == "--queue") {
+			const char *v = value();
+			if (!v || !parse_count(arg, v, options.queue_size)) return false;
+		} else if (arg == "-o" || arg == "--output-dir") {
+			const char *v = value();
+			if (!v) return false;
+			options.output_dir = v;
+		} else if (arg == "-b" || arg == "--batch") {
+			const char *v = value();
+			if (!v) return false;
+			char *parse_end = nullptr;
+			const float fraction = std::strtof(v, &parse_end);
+			if (parse_end == v || *parse_end != '\0') {
+				spdlog::error("Invalid value for {}: {}", arg, v);
+				return false;
+			}
+			options.carve.seamBatchFraction = std::clamp(fraction, 0.0f, 1.0f);
+		} else if (arg == "-H" || arg == "--height") {
+			const char *v = value();
+			std::vector<TargetWidth> heights;
+			if (!v || !parse_widths(v, heights, 100) || heights.size() != 1) return false;
+			options.height = heights[0];
+		} else if (arg == "--transport-map") {
+			options.order = RetargetOrder::TransportMap;
+		} else if (arg == "-f" || arg == "--forward") {
+			options.carve.energyMode = EnergyMode::Forward;
+		} else if (arg == "-p" || arg == "--pyramid") {
+			unsigned int levels = 0;
+			const char *v = value();
+			if (!v || !parse_count(arg, v, levels)) return false;
+			options.carve.pyramidLevels = std::min(8u, levels);
+		} else if (arg == "--index") {
+			options.use_index = true;
+		} else if (!arg.empty() && arg[0] == '-') {
+			spdlog::error("Unknown option: {}", arg);
+			return false;
+		} else {
+			options.inputs.push_back(arg);
+		}
+	}
+	if (options.inputs.empty() || options.widths.empty()) {
+		spdlog::error("Need at least one input image and one target width");
+		return false;
+	}
+	// The data-parallel stages of every carve already run on ThreadPool::shared(), one thread
+	// per core: by default more carving threads would only oversubscribe the cores
+	if (options.threads == 0) options.threads = 1;
+	if (options.queue_size == 0) options.queue_size = 2 * options.threads;
+	return true;
+}
+
+static std::optional<ImageData> load_image(const std::string &path) {
+	int width, height, channels;
+	unsigned char *pixels = stbi_load(path.c_str(), &width, &height, &channels, STBI_rgb);
+	if (!pixels) {
+		spdlog::error("Failed to load image: {}", path);
+		return std::nullopt;
+	}
+	ImageData image(width, height, 3);
+	image.setPixels(pixels, static_cast<size_t>(width) * height * 3);
+	stbi_image_free(pixels);
+	return image;
+}
+
+// Carves one image to every requested width. Returns false if any output failed.
+static bool carve_image(const CarveJob &job, const CliOptions &options) {
+	const ImageData &image = job.image;
+	// Enlarging to w duplicates the (w - width) first seams, so the order has to reach 2 * width - w
+	// (doubling the width is carved separately in two rounds, see SeamCarver::insertSeams)
+	const unsigned int image_width = image.getWidth();
+	unsigned int min_width = image_width;
+	for (const TargetWidth &w : options.widths) {
+		const unsigned int width = w.resolve(image_width);
+		if (width <= image_width) min_width = std::min(min_width, width);
+		else if (width < 2 * image_width) min_width = std::min(min_width, 2 * image_width - width);
+	}
+
+	// Seam removal order down to the narrowest requested width (from the index file if possible)
+	SeamIndexFile index_file;
+	std::vector<unsigned int> computed_order;
+	const unsigned int *removal_order = nullptr;
+	const std::string index_path = job.path + ".seamidx";
+	if (options.use_index && index_file.open(index_path) && index_file.matches(image, min_width, options.carve)) {
+		removal_order = index_file.getRemovalOrder();
+	} else {
+		index_file = SeamIndexFile();
+		computed_order = SeamCarver::computeRemovalOrder(image, min_width, options.carve);
+		if (options.use_index) SeamIndexFile::write(index_path, image, computed_order, min_width, options.carve);
+		removal_order = computed_order.data();
+	}
+
+	const fs::path input(job.path);
+	const fs::path dir = options.output_dir.empty() ? input.parent_path() : fs::path(options.output_dir);
+	bool ok = true;
+	const unsigned int height = options.height ? options.height->resolve(image.getHeight(), 1) : image.getHeight();
+	for (const TargetWidth &w : options.widths) {
+		const unsigned int width = w.resolve(image_width);
+		ImageData carved;
+		if (width <= image_width && height < image.getHeight() && options.order == RetargetOrder::TransportMap) {
+			carved = SeamCarver::retarget(image, width, height, options.carve, RetargetOrder::TransportMap);
+		} else {
+			if (width <= image_width) {
+				carved = CustomImageFilter::applySeamOrder(image, removal_order, width);
+			} else if (width < 2 * image_width) {
+				carved = CustomImageFilter::applySeamInsertion(image, removal_order, width);
+			} else {
+				carved = SeamCarver::insertSeams(image, width, options.carve);
+			}
+			// Horizontal seams on the transposed image
+			if (height < image.getHeight()) carved = SeamCarver::carveHeight(carved, height, options.carve);
+		}
+		const fs::path output = dir / (options.height ? fmt::format("{}_w{}_h{}.png", input.stem().string(), width, height)
+		                                              : fmt::format("{}_w{}.png", input.stem().string(), width));
+		if (!stbi_write_png(output.string().c_str(), carved.getWidth(), carved.getHeight(), carved.getChannels(),
+		                    carved.pixels.data(), static_cast<int>(carved.getRowPitch()))) {
+			spdlog::error("Failed to write image: {}", output.string());
+			ok = false;
+		}
+	}
+	return ok;
+}
+
+int main(int argc, char **argv) {
+	CliOptions options;
+	if (!parse_args(argc, argv, options)) {
+		print_usage();
+		return 2;
+	}
+	if (!options.output_dir.empty()) {
+		std::error_code ec;
+		fs::create_directories(options.output_dir, ec);
+		if (ec) {
+			spdlog::error("Failed to create output directory {}: {}", options.output_dir, ec.message());
+			return 1;
+		}
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	BoundedQueue queue(options.queue_size);
+	std::atomic<unsigned int> failed{0};
+	std::atomic<unsigned int> done{0};
+
+	// Carving threads
+	std::vector<std::thread> workers;
+	for (unsigned int t = 0; t < options.threads; ++t) {
+		workers.emplace_back([&]() {
+			while (std::optional<CarveJob> job = queue.pop()) {
+				if (!carve_image(*job, options)) failed++;
+				spdlog::info("[{}/{}] {}", ++done, options.inputs.size(), job->path);
+			}
+		});
+	}
+
+	// Decode on the main thread, blocking while the queue is full
+	for (const std::string &path : options.inputs) {
+		std::optional<ImageData> image = load_image(path);
+		if (!image) {
+			failed++;
+			continue;
+		}
+		queue.push({path, std::move(*image)});
+	}
+	queue.close();
+	for (std::thread &worker : workers) worker.join();
+
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	spdlog::info("Carved {} images to {} widths in {:.2f} s ({} failed)", options.inputs.size(), options.widths.size(),
+	             seconds, failed.load());
+	return failed.load() == 0 ? 0 : 1;
+}
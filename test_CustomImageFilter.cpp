@@ -1,7 +1,30 @@
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <fstream>
+#include <functional>
+#include <random>
+#include <thread>
+#include "CarveJobScheduler.h"
+#include "CarveStats.h"
 #include "CustomImageFilter.h"
+#include "IncrementalSobel.h"
+#include "SeamCarver.h"
+#include "SeamIndexFile.h"
+#include "ThreadPool.h"
+#include "TripleBuffer.h"
 #include "ImageData.h"
 
+// Image filled with uniformly distributed random values (fixed seed for reproducibility)
+static ImageData randomImage(unsigned int width, unsigned int height, unsigned int channels, unsigned int seed = 42) {
+    ImageData image(width, height, channels);
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> dist(0, 255);
+    for (auto& p : image.pixels) p = static_cast<unsigned char>(dist(rng));
+    return image;
+}
+
 // 5x5 image with a vertical edge in the center
 std::vector<unsigned char> monochrom_vertical_edge_img5x5 = {
     0,   0, 10, 0,  0,
@@ -146,6 +169,24 @@ TEST(CustomImageFilterTest, MinimalSeamEnergyMap) {
 
 }
 
+// parallel (tiled) and SIMD minimal energy map must equal the serial scalar computation
+TEST(CustomImageFilterTest, ParallelMinimalSeamEnergyMap) {
+    ImageData energy = randomImage(517, 301, 1);
+    ThreadPool serial(1);
+    ThreadPool parallel(4);
+
+    CustomImageFilter::setSimdLevel(SimdLevel::Scalar);
+    std::vector<unsigned int> reference = CustomImageFilter::computeMinimalEnergyPathMap(energy, serial);
+
+    for (SimdLevel level : {SimdLevel::Scalar, SimdLevel::SSE41, SimdLevel::AVX2}) {
+        if (level > CustomImageFilter::getSupportedSimdLevel()) continue;
+        CustomImageFilter::setSimdLevel(level);
+        EXPECT_EQ(reference, CustomImageFilter::computeMinimalEnergyPathMap(energy, serial));
+        EXPECT_EQ(reference, CustomImageFilter::computeMinimalEnergyPathMap(energy, parallel));
+    }
+    CustomImageFilter::setSimdLevel(CustomImageFilter::getSupportedSimdLevel());
+}
+
 const std::vector<unsigned int> expected_seam_img5x5 = {
     22, // Row 0, Col 2
     18, // Row 1, Col 1
@@ -213,3 +254,958 @@ TEST(CustomImageFilterTest, SeamRemoval) {
     }
     
 }
+
+// 6x3 RGB-like image (2 channels to check channel handling) where each pixel stores its column
+// and row; three disjoint seams are removed in one pass
+TEST(CustomImageFilterTest, BatchSeamRemoval) {
+    ImageData input(6, 3, 2);
+    for (unsigned int y = 0; y < 3; ++y) {
+        for (unsigned int x = 0; x < 6; ++x) {
+            input.pixels[(y * 6 + x) * 2] = static_cast<unsigned char>(x);
+            input.pixels[(y * 6 + x) * 2 + 1] = static_cast<unsigned char>(y);
+        }
+    }
+
+    // Seam columns per row: {0, 1, 1}, {2, 2, 3}, {5, 4, 4} (rows given bottom to top like identityMinEnergySeam)
+    std::vector<std::vector<unsigned int>> seams = {
+        {2 * 6 + 1, 1 * 6 + 1, 0 * 6 + 0},
+        {2 * 6 + 3, 1 * 6 + 2, 0 * 6 + 2},
+        {2 * 6 + 4, 1 * 6 + 4, 0 * 6 + 5},
+    };
+    CustomImageFilter::removeSeams(input, seams);
+
+    ASSERT_EQ(3u, input.getWidth());
+    ASSERT_EQ(3u * 3u * 2u, input.getPixelCount());
+    const std::vector<unsigned char> expected_columns = {
+        1, 3, 4,
+        0, 3, 5,
+        0, 2, 5
+    };
+    for (unsigned int i = 0; i < expected_columns.size(); ++i) {
+        EXPECT_EQ(expected_columns[i], input.pixels[i * 2]);
+        EXPECT_EQ(i / 3, input.pixels[i * 2 + 1]);
+    }
+}
+
+// seam removal on an image with aligned (padded) rows must give the same pixels as on a
+// packed image, without reallocating or changing the row stride
+TEST(CustomImageFilterTest, PitchedSeamRemoval) {
+    ImageData packed = randomImage(45, 7, 3);
+    ImageData pitched(packed, RowLayout::Aligned);
+    ASSERT_EQ(64u, pitched.getStride());
+    const unsigned char* buffer = pitched.getPixelData();
+
+    for (int i = 0; i < 5; ++i) {
+        ImageData energy = CustomImageFilter::sobel(CustomImageFilter::toGreyscale(pitched));
+        std::vector<unsigned int> pathMap = CustomImageFilter::computeMinimalEnergyPathMap(energy);
+        std::vector<unsigned int> seam = CustomImageFilter::identityMinEnergySeam(pathMap, energy.getWidth(), energy.getHeight());
+        CustomImageFilter::removeSeam(pitched, seam);
+        CustomImageFilter::removeSeam(packed, seam);
+    }
+
+    EXPECT_EQ(40u, pitched.getWidth());
+    EXPECT_EQ(64u, pitched.getStride());
+    EXPECT_EQ(buffer, pitched.getPixelData());
+    ASSERT_TRUE(packed.isPacked());
+    for (unsigned int y = 0; y < packed.getHeight(); ++y) {
+        for (unsigned int i = 0; i < packed.getWidth() * 3; ++i) {
+            EXPECT_EQ(packed.getRow(y)[i], pitched.getRow(y)[i]);
+        }
+    }
+}
+
+// the generation identifies an image's content: copies and edits get a new one, moves keep it
+TEST(ImageDataTest, Generation) {
+    ImageData image = randomImage(8, 4, 3);
+    const uint64_t original = image.getGeneration();
+
+    ImageData copy = image;
+    EXPECT_NE(original, copy.getGeneration());
+    ImageData moved = std::move(image);
+    EXPECT_EQ(original, moved.getGeneration());
+    EXPECT_NE(original, image.getGeneration());
+
+    ImageData energy;
+    CustomImageFilter::sobel(CustomImageFilter::toGreyscale(moved), energy);
+    const uint64_t before = energy.getGeneration();
+    CustomImageFilter::sobel(CustomImageFilter::toGreyscale(copy), energy); // reuses the buffer
+    EXPECT_NE(before, energy.getGeneration());
+
+    uint64_t last = moved.getGeneration();
+    CustomImageFilter::removeSeamColumns(moved, {1, 2, 3, 4});
+    EXPECT_NE(last, moved.getGeneration());
+    last = moved.getGeneration();
+    moved.markModified();
+    EXPECT_NE(last, moved.getGeneration());
+}
+
+// the fused Sobel magnitude must match the magnitude of the separate X / Y gradient images
+TEST(CustomImageFilterTest, FusedSobelMagnitude) {
+    CustomImageFilter::setSimdLevel(SimdLevel::Scalar);
+    ImageData input = randomImage(19, 13, 1);
+    ImageData gradX = CustomImageFilter::sobelX(input);
+    ImageData gradY = CustomImageFilter::sobelY(input);
+    ImageData l2 = CustomImageFilter::sobel(input, EnergyNorm::L2);
+    ImageData l1 = CustomImageFilter::sobel(input, EnergyNorm::L1);
+    CustomImageFilter::setSimdLevel(CustomImageFilter::getSupportedSimdLevel());
+
+    for (size_t i = 0; i < input.getPixelCount(); ++i) {
+        int gx = gradX.pixels[i];
+        int gy = gradY.pixels[i];
+        EXPECT_EQ(std::min(static_cast<int>(std::sqrt(gx * gx + gy * gy)), 255), l2.pixels[i]);
+        EXPECT_EQ(std::min(gx + gy, 255), l1.pixels[i]);
+    }
+
+    // Writing into an existing (larger) output reuses its buffer
+    ImageData reused(25, 13, 1);
+    const unsigned char* buffer = reused.getPixelData();
+    CustomImageFilter::sobel(input, reused, EnergyNorm::L2);
+    EXPECT_EQ(buffer, reused.getPixelData());
+    EXPECT_EQ(l2.pixels, reused.pixels);
+}
+
+// the step plane traces the same seam as backtracking through the map, on every SIMD level
+TEST(CustomImageFilterTest, SeamDirections) {
+    ImageData energy = randomImage(517, 301, 1, 7);
+    // plateaus make the tie preference matter
+    for (unsigned int y = 0; y < 301; ++y) {
+        for (unsigned int x = 100; x < 200; ++x) energy.getRow(y)[x] = 3;
+    }
+    ThreadPool parallel(4);
+
+    CustomImageFilter::setSimdLevel(SimdLevel::Scalar);
+    const std::vector<unsigned int> reference = CustomImageFilter::computeMinimalEnergyPathMap(energy, parallel);
+    const std::vector<unsigned int> referenceSeam = CustomImageFilter::identityMinEnergySeam(reference, 517, 301);
+    for (SimdLevel level : {SimdLevel::Scalar, SimdLevel::SSE41, SimdLevel::AVX2}) {
+        if (level > CustomImageFilter::getSupportedSimdLevel()) continue;
+        CustomImageFilter::setSimdLevel(level);
+        std::vector<int8_t> directions;
+        EXPECT_EQ(reference, CustomImageFilter::computeMinimalEnergyPathMap(energy, directions, parallel));
+        const std::vector<unsigned int> columns = CustomImageFilter::identityMinEnergySeamColumns(reference, directions, 517, 301);
+        ASSERT_EQ(301u, columns.size());
+        for (unsigned int y = 0; y < 301; ++y) EXPECT_EQ(referenceSeam[300 - y], y * 517 + columns[y]);
+
+        // a trace from any last row column is a connected seam ending there
+        for (unsigned int x : {0u, 1u, 150u, 515u, 516u}) {
+            const std::vector<unsigned int> traced = CustomImageFilter::traceSeamColumns(directions, 517, 301, x);
+            EXPECT_EQ(x, traced.back());
+            for (unsigned int y = 1; y < 301; ++y) EXPECT_LE(std::abs(static_cast<int>(traced[y]) - static_cast<int>(traced[y - 1])), 1);
+        }
+    }
+    CustomImageFilter::setSimdLevel(CustomImageFilter::getSupportedSimdLevel());
+
+    // column seams remove the same pixels as index seams
+    ImageData image = randomImage(517, 301, 3, 8);
+    ImageData byIndex = image;
+    std::vector<int8_t> directions;
+    const std::vector<unsigned int> map = CustomImageFilter::computeMinimalEnergyPathMap(energy, directions, parallel);
+    CustomImageFilter::removeSeamColumns(image, CustomImageFilter::identityMinEnergySeamColumns(map, directions, 517, 301));
+    CustomImageFilter::removeSeam(byIndex, referenceSeam);
+    EXPECT_EQ(516u, image.getWidth());
+    EXPECT_EQ(byIndex.pixels, image.pixels);
+}
+
+// 16 bit cost maps hold the same values as 32 bit ones up to 257 rows (worst case energy included)
+TEST(CustomImageFilterTest, CompactCostMap) {
+    ImageData energy = randomImage(517, 257, 1);
+    for (unsigned int x = 0; x < 7; ++x) {
+        for (unsigned int y = 0; y < 257; ++y) energy.getRow(y)[x] = 255;
+    }
+    ThreadPool parallel(4);
+    EXPECT_TRUE(CustomImageFilter::costFits<uint16_t>(257));
+    EXPECT_FALSE(CustomImageFilter::costFits<uint16_t>(258));
+
+    CustomImageFilter::setSimdLevel(SimdLevel::Scalar);
+    const std::vector<unsigned int> reference = CustomImageFilter::computeMinimalEnergyPathMap(energy, parallel);
+    const std::vector<unsigned int> referenceSeam = CustomImageFilter::identityMinEnergySeam(reference, 517, 257);
+    for (SimdLevel level : {SimdLevel::Scalar, SimdLevel::SSE41, SimdLevel::AVX2}) {
+        if (level > CustomImageFilter::getSupportedSimdLevel()) continue;
+        CustomImageFilter::setSimdLevel(level);
+        const std::vector<uint16_t> compact = CustomImageFilter::computeCostMap<uint16_t>(energy, parallel);
+        EXPECT_TRUE(std::equal(reference.begin(), reference.end(), compact.begin(), compact.end()));
+        EXPECT_EQ(referenceSeam, CustomImageFilter::backtrackCostMap(compact, 517, 257));
+        EXPECT_EQ(referenceSeam, CustomImageFilter::findMinEnergySeam(energy, parallel));
+    }
+    CustomImageFilter::setSimdLevel(CustomImageFilter::getSupportedSimdLevel());
+
+    // taller maps are refused in 16 bit and fall back to 32 bit
+    ImageData tall = randomImage(40, 300, 1);
+    EXPECT_TRUE(CustomImageFilter::computeCostMap<uint16_t>(tall, parallel).empty());
+    const std::vector<unsigned int> tallMap = CustomImageFilter::computeMinimalEnergyPathMap(tall);
+    EXPECT_EQ(CustomImageFilter::identityMinEnergySeam(tallMap, 40, 300), CustomImageFilter::findMinEnergySeam(tall));
+}
+
+// SIMD Sobel kernels must reproduce the scalar reference exactly, including the
+// scalar border / remainder handling around the vectorized interior
+class SobelSimdTest : public ::testing::TestWithParam<unsigned int> {
+protected:
+    void TearDown() override { CustomImageFilter::setSimdLevel(CustomImageFilter::getSupportedSimdLevel()); }
+
+    // Runs 'filter' with the scalar path and every supported SIMD level and compares the results
+    template <typename Filter>
+    void expectSameAsScalar(const ImageData& input, Filter filter) {
+        CustomImageFilter::setSimdLevel(SimdLevel::Scalar);
+        ImageData reference = filter(input);
+        for (SimdLevel level : {SimdLevel::SSE41, SimdLevel::AVX2}) {
+            if (level > CustomImageFilter::getSupportedSimdLevel()) continue;
+            CustomImageFilter::setSimdLevel(level);
+            ImageData output = filter(input);
+            ASSERT_EQ(reference.getWidth(), output.getWidth());
+            for (unsigned int y = 0; y < reference.getHeight(); ++y) {
+                for (unsigned int x = 0; x < reference.getWidth(); ++x) {
+                    ASSERT_EQ(reference.getRow(y)[x], output.getRow(y)[x])
+                        << "level " << static_cast<int>(level) << " at (" << x << ", " << y << ")";
+                }
+            }
+        }
+    }
+};
+
+TEST_P(SobelSimdTest, MatchesScalar) {
+    const unsigned int width = GetParam();
+    for (RowLayout layout : {RowLayout::Packed, RowLayout::Aligned}) {
+        ImageData input(randomImage(width, 11, 1, width), layout);
+        expectSameAsScalar(input, CustomImageFilter::sobelX);
+        expectSameAsScalar(input, CustomImageFilter::sobelY);
+        expectSameAsScalar(input, [](const ImageData& in) { return CustomImageFilter::sobel(in, EnergyNorm::L2); });
+        expectSameAsScalar(input, [](const ImageData& in) { return CustomImageFilter::sobel(in, EnergyNorm::L1); });
+    }
+}
+
+TEST_P(SobelSimdTest, LumaMatchesScalar) {
+    const unsigned int width = GetParam();
+    for (unsigned int channels : {3u, 4u}) {
+        for (RowLayout layout : {RowLayout::Packed, RowLayout::Aligned}) {
+            ImageData input(randomImage(width, 5, channels, width + channels), layout);
+            expectSameAsScalar(input, [](const ImageData& in) { return CustomImageFilter::toGreyscale(in); });
+        }
+    }
+}
+
+TEST_P(SobelSimdTest, ResizeMatchesScalar) {
+    const unsigned int width = GetParam();
+    for (unsigned int channels : {3u, 4u}) {
+        ImageData input(randomImage(width, 9, channels, width), RowLayout::Aligned);
+        for (ResampleFilter filter : {ResampleFilter::Bilinear, ResampleFilter::Bicubic, ResampleFilter::Area}) {
+            for (auto [w, h] : {std::pair{width, 4u}, std::pair{width + 5, 20u}, std::pair{width / 3 + 1, 9u}}) {
+                // Compares whole pixels (expectSameAsScalar only checks the first byte per pixel)
+                CustomImageFilter::setSimdLevel(SimdLevel::Scalar);
+                ImageData reference = CustomImageFilter::resize(input, w, h, filter);
+                for (SimdLevel level : {SimdLevel::SSE41, SimdLevel::AVX2}) {
+                    if (level > CustomImageFilter::getSupportedSimdLevel()) continue;
+                    CustomImageFilter::setSimdLevel(level);
+                    ImageData output = CustomImageFilter::resize(input, w, h, filter);
+                    for (unsigned int y = 0; y < h; ++y) {
+                        for (unsigned int i = 0; i < w * channels; ++i) {
+                            ASSERT_EQ(reference.getRow(y)[i], output.getRow(y)[i]) << w << "x" << h << " at byte " << i << ", row " << y;
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(OddWidths, SobelSimdTest, ::testing::Values(3u, 17u, 33u, 35u, 63u, 101u, 257u));
+
+// fixed point luma: exact for grey, white and the primaries, and the same from a raw buffer
+TEST(CustomImageFilterTest, Greyscale) {
+    ImageData rgba(4, 1, 4);
+    const unsigned char pixels[] = {255, 255, 255, 7, 255, 0, 0, 0, 0, 255, 0, 0, 0, 0, 255, 0};
+    rgba.setPixels(pixels, sizeof(pixels));
+    ImageData grey = CustomImageFilter::toGreyscale(rgba);
+    ASSERT_EQ(1u, grey.getChannels());
+    EXPECT_EQ(255, grey.getRow(0)[0]);
+    EXPECT_EQ(76, grey.getRow(0)[1]);  // 0.299 * 255
+    EXPECT_EQ(150, grey.getRow(0)[2]); // 0.587 * 255
+    EXPECT_EQ(29, grey.getRow(0)[3]);  // 0.114 * 255
+
+    ImageData rgb = randomImage(37, 3, 3);
+    for (unsigned int y = 0; y < 3; ++y) rgb.getRow(y)[0] = rgb.getRow(y)[1] = rgb.getRow(y)[2] = 100;
+    grey = CustomImageFilter::toGreyscale(rgb);
+    ImageData raw = CustomImageFilter::toGreyscale(rgb.getPixelData(), 37, 3, 3, RowLayout::Aligned);
+    EXPECT_EQ(RowLayout::Aligned, raw.getLayout());
+    for (unsigned int y = 0; y < 3; ++y) {
+        EXPECT_EQ(100, grey.getRow(y)[0]);
+        for (unsigned int x = 0; x < 37; ++x) EXPECT_EQ(grey.getRow(y)[x], raw.getRow(y)[x]);
+    }
+
+    ImageData single = randomImage(5, 2, 1);
+    ImageData greyAlpha = randomImage(5, 2, 2);
+    ImageData copied = CustomImageFilter::toGreyscale(single);
+    ImageData dropped = CustomImageFilter::toGreyscale(greyAlpha);
+    for (unsigned int x = 0; x < 5; ++x) {
+        EXPECT_EQ(single.getRow(1)[x], copied.getRow(1)[x]);
+        EXPECT_EQ(greyAlpha.getRow(1)[2 * x], dropped.getRow(1)[x]);
+    }
+    EXPECT_EQ(0u, CustomImageFilter::toGreyscale(randomImage(4, 4, 5)).getWidth());
+}
+
+// flat images stay flat, area downscaling averages, and splitting rows over threads changes nothing
+TEST(CustomImageFilterTest, Resize) {
+    for (ResampleFilter filter : {ResampleFilter::Bilinear, ResampleFilter::Bicubic, ResampleFilter::Area}) {
+        ImageData flat(23, 17, 3);
+        std::fill(flat.pixels.begin(), flat.pixels.end(), 200);
+        for (auto [w, h] : {std::pair{7u, 5u}, std::pair{50u, 40u}, std::pair{23u, 3u}, std::pair{1u, 1u}}) {
+            ImageData resized = CustomImageFilter::resize(flat, w, h, filter);
+            ASSERT_EQ(w, resized.getWidth());
+            ASSERT_EQ(h, resized.getHeight());
+            for (unsigned int y = 0; y < h; ++y) {
+                for (unsigned int i = 0; i < w * 3; ++i) ASSERT_EQ(200, resized.getRow(y)[i]);
+            }
+        }
+    }
+
+    ImageData image = randomImage(40, 40, 1);
+    ImageData half = CustomImageFilter::resize(image, 20, 20, ResampleFilter::Area);
+    for (unsigned int y = 0; y < 20; ++y) {
+        for (unsigned int x = 0; x < 20; ++x) {
+            const int sum = image.getRow(2 * y)[2 * x] + image.getRow(2 * y)[2 * x + 1] +
+                            image.getRow(2 * y + 1)[2 * x] + image.getRow(2 * y + 1)[2 * x + 1];
+            EXPECT_NEAR(sum / 4.0, half.getRow(y)[x], 1.0); // 8 bit between the passes
+        }
+    }
+
+    ImageData large = randomImage(300, 200, 4);
+    ThreadPool single(1);
+    ThreadPool parallel(4);
+    ImageData a = CustomImageFilter::resize(large, 123, 77, ResampleFilter::Bicubic, single);
+    ImageData b = CustomImageFilter::resize(large, 123, 77, ResampleFilter::Bicubic, parallel);
+    EXPECT_EQ(a.pixels, b.pixels);
+
+    EXPECT_EQ(0u, CustomImageFilter::resize(image, 0, 10).getWidth());
+}
+
+// incremental energy update must match a full Sobel recompute after every seam
+TEST(IncrementalSobelTest, MatchesFullRecompute) {
+    ImageData greyscale(randomImage(37, 23, 1), RowLayout::Aligned);
+    IncrementalSobel sobel(greyscale);
+
+    while (sobel.getGreyscale().getWidth() > 3) {
+        const ImageData& energy = sobel.getEnergy();
+        std::vector<unsigned int> pathMap = CustomImageFilter::computeMinimalEnergyPathMap(energy);
+        std::vector<unsigned int> seam = CustomImageFilter::identityMinEnergySeam(pathMap, energy.getWidth(), energy.getHeight());
+        sobel.removeSeam(seam);
+
+        ImageData truth = CustomImageFilter::sobel(ImageData(sobel.getGreyscale(), RowLayout::Packed));
+        for (unsigned int y = 0; y < truth.getHeight(); ++y) {
+            for (unsigned int x = 0; x < truth.getWidth(); ++x) {
+                ASSERT_EQ(truth.getRow(y)[x], sobel.getEnergy().getRow(y)[x]) << "width " << truth.getWidth();
+            }
+        }
+    }
+}
+
+// several seams extracted from one map: pixel-disjoint, one pixel per row each, and the
+// first one is the optimal seam
+TEST(CustomImageFilterTest, MultiSeamDetection) {
+    ImageData energy = CustomImageFilter::sobel(randomImage(40, 30, 1));
+    std::vector<unsigned int> pathMap = CustomImageFilter::computeMinimalEnergyPathMap(energy);
+    std::vector<std::vector<unsigned int>> seams = CustomImageFilter::identityMinEnergySeams(pathMap, 40, 30, 8);
+
+    ASSERT_FALSE(seams.empty());
+    EXPECT_LE(seams.size(), 8u);
+    EXPECT_EQ(CustomImageFilter::identityMinEnergySeam(pathMap, 40, 30), seams.front());
+
+    std::vector<int> used(40 * 30, 0);
+    for (const auto& seam : seams) {
+        ASSERT_EQ(30u, seam.size());
+        for (size_t i = 0; i < seam.size(); ++i) {
+            EXPECT_EQ(29u - i, seam[i] / 40); // bottom to top
+            if (i > 0) {
+                EXPECT_LE(std::abs(static_cast<int>(seam[i] % 40) - static_cast<int>(seam[i - 1] % 40)), 1);
+            }
+            EXPECT_EQ(0, used[seam[i]]++);
+        }
+    }
+}
+
+// batch removal keeps the incrementally updated energy identical to a full recompute
+TEST(IncrementalSobelTest, BatchMatchesFullRecompute) {
+    IncrementalSobel sobel(randomImage(61, 17, 1, 7));
+
+    while (sobel.getGreyscale().getWidth() > 10) {
+        const ImageData& energy = sobel.getEnergy();
+        std::vector<unsigned int> pathMap = CustomImageFilter::computeMinimalEnergyPathMap(energy);
+        sobel.removeSeams(CustomImageFilter::identityMinEnergySeams(pathMap, energy.getWidth(), energy.getHeight(), 6));
+
+        ImageData truth = CustomImageFilter::sobel(sobel.getGreyscale());
+        ASSERT_EQ(truth.pixels, sobel.getEnergy().pixels) << "width " << truth.getWidth();
+    }
+
+    // seams with a pixel outside the image or a row twice are rejected without touching anything
+    const ImageData before = sobel.getEnergy();
+    std::vector<unsigned int> outside(17), repeated(17);
+    const unsigned int width = before.getWidth();
+    for (unsigned int y = 0; y < 17; ++y) {
+        outside[y] = y * width;
+        repeated[y] = (y / 2) * width;
+    }
+    outside.back() = width * 17;
+    sobel.removeSeams({outside});
+    sobel.removeSeams({repeated});
+    EXPECT_EQ(width, sobel.getGreyscale().getWidth());
+    EXPECT_EQ(before.pixels, sobel.getEnergy().pixels);
+}
+
+// carving to any width from the precomputed removal order gives the same image as
+// carving seam by seam from the original
+TEST(SeamCarverTest, RemovalOrderMatchesSequentialCarving) {
+    ImageData source = randomImage(30, 12, 3, 3);
+    std::vector<unsigned int> order = SeamCarver::computeRemovalOrder(source, 3);
+    ASSERT_EQ(30u * 12u, order.size());
+
+    ImageData reference = source;
+    while (reference.getWidth() > 3) {
+        ImageData energy = CustomImageFilter::sobel(CustomImageFilter::toGreyscale(reference));
+        std::vector<unsigned int> pathMap = CustomImageFilter::computeMinimalEnergyPathMap(energy);
+        CustomImageFilter::removeSeam(reference, CustomImageFilter::identityMinEnergySeam(pathMap, energy.getWidth(), energy.getHeight()));
+
+        ImageData carved = CustomImageFilter::applySeamOrder(source, order.data(), reference.getWidth());
+        ASSERT_EQ(reference.pixels, carved.pixels) << "width " << reference.getWidth();
+    }
+
+    // full width is the identity
+    EXPECT_EQ(source.pixels, CustomImageFilter::applySeamOrder(source, order.data(), 30).pixels);
+}
+
+// every intermediate image of the index build is already the answer for its width
+TEST(SeamCarverTest, RemovalOrderSnapshots) {
+    ImageData source = randomImage(40, 14, 3, 22);
+    std::vector<unsigned int> widths;
+    std::vector<ImageData> images;
+    std::vector<unsigned int> order = SeamCarver::computeRemovalOrder(source, 30, {}, nullptr, [&](const SeamCarver& carver) {
+        widths.push_back(carver.getWidth());
+        images.push_back(carver.getImage());
+        EXPECT_EQ(carver.getWidth(), carver.getEnergy().getWidth());
+    });
+    ASSERT_EQ(10u, widths.size());
+    for (size_t i = 0; i < widths.size(); ++i) {
+        EXPECT_EQ(39u - i, widths[i]);
+        const ImageData reference = CustomImageFilter::applySeamOrder(source, order.data(), widths[i]);
+        for (unsigned int y = 0; y < 14; ++y) {
+            ASSERT_TRUE(std::equal(reference.getRow(y), reference.getRow(y) + widths[i] * 3, images[i].getRow(y))) << widths[i];
+        }
+    }
+}
+
+TEST(SeamIndexFileTest, RoundTripBothEncodings) {
+    ImageData source = randomImage(40, 16, 3, 9);
+    std::vector<unsigned int> order = SeamCarver::computeRemovalOrder(source, 4);
+    const std::string path = ::testing::TempDir() + "seam_index_test.seamidx";
+
+    for (SeamIndexEncoding encoding : {SeamIndexEncoding::Raw, SeamIndexEncoding::DeltaVarint}) {
+        ASSERT_TRUE(SeamIndexFile::write(path, source, order, 4, {}, encoding));
+        SeamIndexFile file;
+        ASSERT_TRUE(file.open(path));
+        EXPECT_TRUE(file.matches(source, 4));
+        EXPECT_TRUE(file.matches(source, 10)); // also valid for wider minimal widths
+        EXPECT_FALSE(file.matches(source, 3));
+        ASSERT_EQ(order, std::vector<unsigned int>(file.getRemovalOrder(), file.getRemovalOrder() + order.size()));
+
+        // another image of the same size is rejected by the fingerprint
+        EXPECT_FALSE(file.matches(randomImage(40, 16, 3, 10), 4));
+        // as is an index built with other carving options
+        SeamCarveOptions batched;
+        batched.seamBatchFraction = 0.25f;
+        EXPECT_FALSE(file.matches(source, 4, batched));
+    }
+
+    // a damaged header must not make open() allocate for dimensions the payload cannot hold
+    ASSERT_TRUE(SeamIndexFile::write(path, source, order, 4, {}, SeamIndexEncoding::DeltaVarint));
+    {
+        std::fstream stream(path, std::ios::in | std::ios::out | std::ios::binary);
+        const uint32_t huge[2] = {100000, 100000};
+        stream.seekp(offsetof(SeamIndexHeader, width));
+        stream.write(reinterpret_cast<const char*>(huge), sizeof(huge));
+    }
+    SeamIndexFile damaged;
+    EXPECT_FALSE(damaged.open(path));
+
+    // as must a raw plane that removes one seam twice in a row (and another not at all)
+    ASSERT_TRUE(SeamIndexFile::write(path, source, order, 4, {}, SeamIndexEncoding::Raw));
+    ASSERT_TRUE(damaged.open(path));
+    damaged = SeamIndexFile();
+    {
+        const auto first = std::find_if(order.begin(), order.end(), [](unsigned int v) { return v < 36; });
+        const auto second = std::find_if(first + 1, order.begin() + 40, [](unsigned int v) { return v < 36; });
+        std::fstream stream(path, std::ios::in | std::ios::out | std::ios::binary);
+        stream.seekp(sizeof(SeamIndexHeader) + (first - order.begin()) * sizeof(unsigned int));
+        stream.write(reinterpret_cast<const char*>(&*second), sizeof(unsigned int));
+    }
+    EXPECT_FALSE(damaged.open(path));
+    std::remove(path.c_str());
+}
+
+TEST(CarveStatsTest, RecordsEveryStage) {
+    CarveStats stats;
+    SeamCarveOptions options;
+    options.stats = &stats;
+    ImageData source = randomImage(24, 10, 3, 4);
+    SeamCarver::computeRemovalOrder(source, 20, options);
+
+    const CarveStatsSnapshot snapshot = stats.snapshot();
+    EXPECT_EQ(4u, snapshot.seams);
+    EXPECT_GT(snapshot.bytesAllocated, 0u);
+    // One initial energy pass / DP + one update per seam
+    for (CarveStage stage : {CarveStage::Energy, CarveStage::MinimalPath, CarveStage::Backtrack, CarveStage::Removal}) {
+        const CarveStatsSnapshot::Stage& counters = snapshot.stages[static_cast<size_t>(stage)];
+        const bool incremental = stage == CarveStage::Energy || stage == CarveStage::MinimalPath;
+        EXPECT_EQ(incremental ? 5u : 4u, counters.count) << carveStageName(stage);
+        uint64_t histogramTotal = 0;
+        for (uint64_t bucket : counters.histogram) histogramTotal += bucket;
+        EXPECT_EQ(counters.count, histogramTotal);
+    }
+
+    EXPECT_NE(std::string::npos, stats.toJson().find("\"minimal_path\":{\"count\":5"));
+    const std::string trace = stats.toChromeTrace();
+    size_t events = 0;
+    for (size_t pos = trace.find("\"ph\":\"X\""); pos != std::string::npos; pos = trace.find("\"ph\":\"X\"", pos + 1)) ++events;
+    EXPECT_EQ(18u, events);
+}
+
+TEST(CustomImageFilterTest, ForwardEnergyPathMap) {
+    ImageData grey = randomImage(300, 260, 1, 11);
+    const unsigned int w = grey.getWidth(), h = grey.getHeight();
+    auto I = [&](int x, int y) { return static_cast<int>(grey.getRow(y)[std::clamp(x, 0, static_cast<int>(w) - 1)]); };
+
+    // Straightforward reference of the forward energy recurrence
+    std::vector<unsigned int> expected(w * h);
+    for (unsigned int y = 0; y < h; ++y) {
+        for (int x = 0; x < static_cast<int>(w); ++x) {
+            const unsigned int cU = std::abs(I(x + 1, y) - I(x - 1, y));
+            if (y == 0) { expected[x] = cU; continue; }
+            const unsigned int* above = &expected[(y - 1) * w];
+            unsigned int best = above[x] + cU;
+            if (x > 0) best = std::min(best, above[x - 1] + cU + std::abs(I(x, y - 1) - I(x - 1, y)));
+            if (x + 1 < static_cast<int>(w)) best = std::min(best, above[x + 1] + cU + std::abs(I(x, y - 1) - I(x + 1, y)));
+            expected[y * w + x] = best;
+        }
+    }
+
+    ThreadPool serial(1), parallel(4);
+    const SimdLevel defaultLevel = CustomImageFilter::getSimdLevel();
+    for (int level = 0; level <= static_cast<int>(CustomImageFilter::getSupportedSimdLevel()); ++level) {
+        CustomImageFilter::setSimdLevel(static_cast<SimdLevel>(level));
+        EXPECT_EQ(expected, CustomImageFilter::computeForwardEnergyPathMap(grey, serial)) << "SIMD level " << level;
+        EXPECT_EQ(expected, CustomImageFilter::computeForwardEnergyPathMap(grey, parallel)) << "SIMD level " << level;
+    }
+    CustomImageFilter::setSimdLevel(defaultLevel);
+    std::vector<unsigned int> map = CustomImageFilter::computeForwardEnergyPathMap(grey, serial);
+
+    // The backtracked seam is connected and its step costs add up to the minimal total
+    std::vector<unsigned int> seam = CustomImageFilter::identityForwardEnergySeam(map, grey);
+    ASSERT_EQ(h, seam.size());
+    int x = seam[0] % w;
+    unsigned int cost = 0;
+    for (unsigned int i = 0; i < h; ++i) {
+        const unsigned int y = h - 1 - i;
+        ASSERT_EQ(y, seam[i] / w);
+        const int sx = seam[i] % w;
+        ASSERT_LE(std::abs(sx - x), 1);
+        cost += std::abs(I(sx + 1, y) - I(sx - 1, y));
+        if (i > 0 && x != sx) cost += std::abs(I(x, y) - I(sx == x - 1 ? x - 1 : x + 1, y + 1));
+        x = sx;
+    }
+    EXPECT_EQ(*std::min_element(map.end() - w, map.end()), cost);
+}
+
+TEST(SeamCarverTest, ForwardEnergyMatchesSequentialCarving) {
+    ImageData source = randomImage(28, 14, 3, 5);
+    SeamCarveOptions options;
+    options.energyMode = EnergyMode::Forward;
+    std::vector<unsigned int> order = SeamCarver::computeRemovalOrder(source, 5, options);
+
+    ImageData reference = source;
+    while (reference.getWidth() > 5) {
+        ImageData grey = CustomImageFilter::toGreyscale(reference);
+        std::vector<unsigned int> pathMap = CustomImageFilter::computeForwardEnergyPathMap(grey);
+        CustomImageFilter::removeSeam(reference, CustomImageFilter::identityForwardEnergySeam(pathMap, grey));
+
+        ImageData carved = CustomImageFilter::applySeamOrder(source, order.data(), reference.getWidth());
+        ASSERT_EQ(reference.pixels, carved.pixels) << "width " << reference.getWidth();
+    }
+}
+
+TEST(CustomImageFilterTest, TransposeBlocked) {
+    for (unsigned int channels : {1u, 3u, 2u}) {
+        ImageData image = randomImage(131, 70, channels, channels);
+        ImageData transposed = CustomImageFilter::transpose(image);
+        ASSERT_EQ(70u, transposed.getWidth());
+        ASSERT_EQ(131u, transposed.getHeight());
+        for (unsigned int y = 0; y < 70; ++y) {
+            for (unsigned int x = 0; x < 131; ++x) {
+                for (unsigned int c = 0; c < channels; ++c) {
+                    ASSERT_EQ(image.getRow(y)[x * channels + c], transposed.getRow(x)[y * channels + c]);
+                }
+            }
+        }
+        EXPECT_EQ(image.pixels, CustomImageFilter::transpose(transposed).pixels);
+    }
+}
+
+TEST(SeamCarverTest, CarveHeightMatchesColumnWiseReference) {
+    ImageData source = randomImage(18, 26, 3, 21);
+    ImageData carved = SeamCarver::carveHeight(source, 20);
+    ASSERT_EQ(18u, carved.getWidth());
+    ASSERT_EQ(20u, carved.getHeight());
+
+    // Horizontal seams the naive way: DP along columns, removal shifts every column up
+    ImageData reference = source;
+    while (reference.getHeight() > 20) {
+        const unsigned int w = reference.getWidth(), h = reference.getHeight();
+        ImageData energy = CustomImageFilter::sobel(CustomImageFilter::toGreyscale(reference));
+        std::vector<unsigned int> map(w * h); // column-major: map[x * h + y]
+        for (unsigned int y = 0; y < h; ++y) map[y] = energy.getRow(y)[0];
+        for (unsigned int x = 1; x < w; ++x) {
+            for (unsigned int y = 0; y < h; ++y) {
+                unsigned int best = map[(x - 1) * h + y];
+                if (y > 0) best = std::min(best, map[(x - 1) * h + y - 1]);
+                if (y + 1 < h) best = std::min(best, map[(x - 1) * h + y + 1]);
+                map[x * h + y] = energy.getRow(y)[x] + best;
+            }
+        }
+        std::vector<unsigned int> seamY(w);
+        const unsigned int* last = &map[(w - 1) * h];
+        seamY[w - 1] = static_cast<unsigned int>(std::min_element(last, last + h) - last);
+        for (unsigned int x = w - 1; x > 0; --x) {
+            const unsigned int* prev = &map[(x - 1) * h];
+            unsigned int y = seamY[x];
+            int step = 0;
+            unsigned int best = prev[y];
+            if (y > 0 && prev[y - 1] < best) { best = prev[y - 1]; step = -1; }
+            if (y + 1 < h && prev[y + 1] < best) { step = 1; }
+            seamY[x - 1] = y + step;
+        }
+        ImageData next(w, h - 1, 3);
+        for (unsigned int x = 0; x < w; ++x) {
+            for (unsigned int y = 0, out = 0; y < h; ++y) {
+                if (y == seamY[x]) continue;
+                std::copy_n(reference.getRow(y) + x * 3, 3, next.getRow(out++) + x * 3);
+            }
+        }
+        reference = std::move(next);
+    }
+    EXPECT_EQ(reference.pixels, carved.pixels);
+}
+
+TEST(SeamCarverTest, RetargetBothDirections) {
+    ImageData source = randomImage(20, 16, 3, 8);
+    for (RetargetOrder order : {RetargetOrder::WidthFirst, RetargetOrder::TransportMap}) {
+        ImageData carved = SeamCarver::retarget(source, 15, 12, {}, order);
+        EXPECT_EQ(15u, carved.getWidth());
+        EXPECT_EQ(12u, carved.getHeight());
+        EXPECT_EQ(15u * 12u * 3u, carved.pixels.size());
+        // cancelling returns an empty image
+        EXPECT_EQ(0u, SeamCarver::retarget(source, 15, 12, {}, order, [](unsigned int, unsigned int) { return false; }).getWidth());
+    }
+    // a single direction does not depend on the order
+    EXPECT_EQ(SeamCarver::retarget(source, 20, 11).pixels, SeamCarver::retarget(source, 20, 11, {}, RetargetOrder::TransportMap).pixels);
+
+    // brute force over every order of r horizontal and c vertical seams: the transport map
+    // result is one of them, the cheapest for a 1x1 table, and with a single row never more
+    // expensive than width first (it compares against that order in its last cell)
+    ImageData small = randomImage(9, 8, 3, 10);
+    for (unsigned int rows = 1; rows <= 2; ++rows) {
+        for (unsigned int columns = 1; columns <= 3; ++columns) {
+            const ImageData carved = SeamCarver::retarget(small, 9 - columns, 8 - rows, {}, RetargetOrder::TransportMap);
+            uint64_t bestCost = UINT64_MAX, carvedCost = UINT64_MAX, widthFirstCost = 0;
+            std::function<void(const ImageData&, unsigned int, unsigned int, uint64_t, bool)> tryOrders =
+                [&](const ImageData& image, unsigned int r, unsigned int c, uint64_t cost, bool widthFirst) {
+                    if (r == 0 && c == 0) {
+                        bestCost = std::min(bestCost, cost);
+                        if (ImageData(image, RowLayout::Packed).pixels == carved.pixels) carvedCost = std::min(carvedCost, cost);
+                        if (widthFirst) widthFirstCost = cost;
+                        return;
+                    }
+                    if (c) {
+                        ImageData next = image;
+                        const unsigned int seamCost = SeamCarver::removeCheapestSeam(next, false);
+                        tryOrders(next, r, c - 1, cost + seamCost, widthFirst);
+                    }
+                    if (r) {
+                        ImageData next = image;
+                        const unsigned int seamCost = SeamCarver::removeCheapestSeam(next, true);
+                        tryOrders(next, r - 1, c, cost + seamCost, widthFirst && c == 0);
+                    }
+                };
+            tryOrders(small, rows, columns, 0, true);
+            ASSERT_NE(UINT64_MAX, carvedCost) << rows << " rows, " << columns << " columns";
+            if (rows == 1 && columns == 1) {
+                EXPECT_EQ(bestCost, carvedCost);
+            }
+            if (rows == 1) {
+                EXPECT_LE(carvedCost, widthFirstCost) << columns << " columns";
+            }
+        }
+    }
+
+    // a table too large for the image falls back to width first instead of running for hours
+    ImageData large = randomImage(600, 600, 3, 11);
+    EXPECT_EQ(SeamCarver::retarget(large, 540, 540).pixels, SeamCarver::retarget(large, 540, 540, {}, RetargetOrder::TransportMap).pixels);
+}
+
+// every pixel of the k first seams is followed by its average with the right neighbour,
+// removing the inserted pixels again gives back the source
+TEST(SeamCarverTest, SeamInsertion) {
+    ImageData source = randomImage(24, 10, 3, 9);
+    const unsigned int inserted = 7;
+    std::vector<unsigned int> order = SeamCarver::computeRemovalOrder(source, 24 - inserted);
+    ImageData enlarged = CustomImageFilter::applySeamInsertion(source, order.data(), 24 + inserted);
+    ASSERT_EQ(31u, enlarged.getWidth());
+    ASSERT_EQ(10u, enlarged.getHeight());
+
+    for (unsigned int y = 0; y < 10; ++y) {
+        const unsigned char* in = source.getRow(y);
+        const unsigned char* out = enlarged.getRow(y);
+        for (unsigned int x = 0; x < 24; ++x) {
+            const unsigned char* right = in + (x + 1 < 24 ? x + 1 : x) * 3;
+            for (unsigned int c = 0; c < 3; ++c) ASSERT_EQ(in[x * 3 + c], out[c]) << "row " << y << " column " << x;
+            out += 3;
+            if (order[y * 24 + x] >= inserted) continue;
+            for (unsigned int c = 0; c < 3; ++c) EXPECT_EQ((in[x * 3 + c] + right[c] + 1) / 2, out[c]);
+            out += 3;
+        }
+    }
+
+    // the order has to reach down far enough
+    EXPECT_EQ(0u, CustomImageFilter::applySeamInsertion(source, order.data(), 24 + inserted + 1).getWidth());
+    // doubling the width takes two rounds
+    ImageData doubled = SeamCarver::insertSeams(source, 48);
+    EXPECT_EQ(48u, doubled.getWidth());
+    EXPECT_EQ(48u * 10u * 3u, doubled.pixels.size());
+    EXPECT_EQ(source.pixels, SeamCarver::insertSeams(source, 24).pixels);
+}
+
+// a band covering the whole width is the plain DP; a narrow band keeps the seam inside it
+TEST(CustomImageFilterTest, BandedMinimalSeamEnergyMap) {
+    ImageData energy = randomImage(60, 50, 1, 12);
+    const unsigned int w = energy.getWidth(), h = energy.getHeight();
+    std::vector<unsigned int> map = CustomImageFilter::computeMinimalEnergyPathMap(energy);
+
+    const SimdLevel defaultLevel = CustomImageFilter::getSimdLevel();
+    for (int level = 0; level <= static_cast<int>(CustomImageFilter::getSupportedSimdLevel()); ++level) {
+        CustomImageFilter::setSimdLevel(static_cast<SimdLevel>(level));
+        std::vector<unsigned int> full(h, 0);
+        std::vector<unsigned int> bandMap = CustomImageFilter::computeMinimalEnergyPathMapInBand(energy, full, w);
+        EXPECT_EQ(map, bandMap) << "SIMD level " << level;
+        EXPECT_EQ(CustomImageFilter::identityMinEnergySeam(map, w, h), CustomImageFilter::identityMinEnergySeamInBand(bandMap, full, w, w, h));
+    }
+    CustomImageFilter::setSimdLevel(defaultLevel);
+
+    // band of 12 columns moving right by 4 columns every 4 rows (clamped at the right edge)
+    std::vector<unsigned int> bandStart(h);
+    for (unsigned int y = 0; y < h; ++y) bandStart[y] = y / 4 * 4 + 4;
+    std::vector<unsigned int> bandMap = CustomImageFilter::computeMinimalEnergyPathMapInBand(energy, bandStart, 12);
+    std::vector<unsigned int> seam = CustomImageFilter::identityMinEnergySeamInBand(bandMap, bandStart, 12, w, h);
+    ASSERT_EQ(h, seam.size());
+    unsigned int cost = 0;
+    for (unsigned int i = 0; i < h; ++i) {
+        const unsigned int y = h - 1 - i, x = seam[i] % w;
+        ASSERT_EQ(y, seam[i] / w);
+        EXPECT_GE(x, std::min(bandStart[y], w - 12));
+        EXPECT_LT(x, std::min(bandStart[y], w - 12) + 12);
+        if (i > 0) {
+            EXPECT_LE(std::abs(static_cast<int>(x) - static_cast<int>(seam[i - 1] % w)), 1);
+        }
+        cost += energy.getRow(y)[x];
+    }
+    EXPECT_EQ(*std::min_element(bandMap.end() - 12, bandMap.end()), cost);
+    EXPECT_GE(cost, *std::min_element(map.end() - w, map.end()));
+}
+
+TEST(CustomImageFilterTest, DownsampleMax2) {
+    ImageData energy = randomImage(203, 51, 1, 15); // odd sizes: clamped last column / row
+    const SimdLevel defaultLevel = CustomImageFilter::getSimdLevel();
+    for (int level = 0; level <= static_cast<int>(CustomImageFilter::getSupportedSimdLevel()); ++level) {
+        CustomImageFilter::setSimdLevel(static_cast<SimdLevel>(level));
+        ImageData coarse = CustomImageFilter::downsampleMax2(energy);
+        ASSERT_EQ(102u, coarse.getWidth());
+        ASSERT_EQ(26u, coarse.getHeight());
+        for (unsigned int y = 0; y < 26; ++y) {
+            for (unsigned int x = 0; x < 102; ++x) {
+                unsigned char expected = 0;
+                for (unsigned int dy = 0; dy < 2; ++dy) {
+                    for (unsigned int dx = 0; dx < 2; ++dx) {
+                        expected = std::max(expected, energy.getRow(std::min(2 * y + dy, 50u))[std::min(2 * x + dx, 202u)]);
+                    }
+                }
+                ASSERT_EQ(expected, coarse.getRow(y)[x]) << "SIMD level " << level << " at " << x << ", " << y;
+            }
+        }
+    }
+    CustomImageFilter::setSimdLevel(defaultLevel);
+}
+
+// with the low energy region inside the band, coarse-to-fine finds the exact seams
+TEST(SeamCarverTest, PyramidMatchesFullResolution) {
+    ImageData source = randomImage(160, 48, 3, 13);
+    for (unsigned int y = 0; y < 48; ++y) {
+        for (unsigned int x = 64; x < 80; ++x) std::memset(source.getRow(y) + x * 3, 128, 3);
+    }
+    SeamCarveOptions pyramid;
+    pyramid.pyramidLevels = 2;
+    EXPECT_EQ(SeamCarver::computeRemovalOrder(source, 157), SeamCarver::computeRemovalOrder(source, 157, pyramid));
+
+    // any image: valid removal order down to the minimal width
+    ImageData noise = randomImage(160, 48, 3, 14);
+    std::vector<unsigned int> order = SeamCarver::computeRemovalOrder(noise, 100, pyramid);
+    EXPECT_EQ(100u, CustomImageFilter::applySeamOrder(noise, order.data(), 100).getWidth());
+}
+
+// updating only the dirty cone gives the full recompute
+TEST(CustomImageFilterTest, IncrementalMinimalSeamEnergyMap) {
+    ImageData energy = randomImage(150, 100, 1, 16);
+    std::vector<unsigned int> map = CustomImageFilter::computeMinimalEnergyPathMap(energy);
+
+    std::mt19937 rng(17);
+    std::vector<unsigned int> dirtyBegin(100), dirtyEnd(100);
+    for (unsigned int y = 0; y < 100; ++y) {
+        // a drifting 3 column wide change, like around a removed seam; some rows untouched
+        dirtyBegin[y] = 60 + y / 4;
+        dirtyEnd[y] = y % 7 == 3 ? dirtyBegin[y] : dirtyBegin[y] + 3;
+        for (unsigned int x = dirtyBegin[y]; x < dirtyEnd[y]; ++x) energy.getRow(y)[x] = static_cast<unsigned char>(rng());
+    }
+    const size_t cells = CustomImageFilter::updateMinimalEnergyPathMap(energy, map, dirtyBegin, dirtyEnd);
+    EXPECT_EQ(CustomImageFilter::computeMinimalEnergyPathMap(energy), map);
+    EXPECT_LT(cells, 150u * 100u);
+
+    // the seam carver keeps its map in sync the same way: same seams as recomputing every time
+    ImageData source = randomImage(130, 40, 3, 18);
+    std::vector<unsigned int> order = SeamCarver::computeRemovalOrder(source, 100);
+    ImageData reference = source;
+    while (reference.getWidth() > 100) {
+        ImageData sobel = CustomImageFilter::sobel(CustomImageFilter::toGreyscale(reference));
+        std::vector<unsigned int> pathMap = CustomImageFilter::computeMinimalEnergyPathMap(sobel);
+        CustomImageFilter::removeSeam(reference, CustomImageFilter::identityMinEnergySeam(pathMap, sobel.getWidth(), sobel.getHeight()));
+    }
+    EXPECT_EQ(reference.pixels, CustomImageFilter::applySeamOrder(source, order.data(), 100).pixels);
+}
+
+// several threads running parallel loops on one pool (callers help each other) all complete
+TEST(ThreadPoolTest, ConcurrentCallers) {
+    ThreadPool pool(3);
+    std::vector<std::thread> callers;
+    std::vector<uint64_t> sums(4, 0);
+    for (unsigned int c = 0; c < sums.size(); ++c) {
+        callers.emplace_back([&, c]() {
+            for (unsigned int round = 0; round < 50; ++round) {
+                std::vector<uint64_t> values(64, 0);
+                pool.parallelFor(64, [&](unsigned int i) { values[i] = i + c; });
+                for (uint64_t v : values) sums[c] += v;
+            }
+        });
+    }
+    for (auto& caller : callers) caller.join();
+    for (unsigned int c = 0; c < sums.size(); ++c) EXPECT_EQ(50u * (64u * 63u / 2 + 64u * c), sums[c]);
+}
+
+TEST(CarveJobSchedulerTest, PrioritiesAndCancellation) {
+    CarveJobScheduler scheduler(1);
+    std::promise<void> gate;
+    std::shared_future<void> opened = gate.get_future().share();
+    std::mutex mtx;
+    std::vector<int> ran;
+    auto record = [&](int value) {
+        return [&, value](const CarveJobContext&) {
+            std::lock_guard<std::mutex> lk(mtx);
+            ran.push_back(value);
+            return ImageData();
+        };
+    };
+
+    // keeps the only thread busy while the others queue up
+    CarveJobHandle blocker = scheduler.submit([opened](const CarveJobContext&) { opened.wait(); return ImageData(); });
+    while (blocker.getState() != CarveJobState::Running) std::this_thread::yield();
+    CarveJobHandle low = scheduler.submit(record(1), 0);
+    CarveJobHandle dropped = scheduler.submit(record(2), 3);
+    CarveJobHandle high = scheduler.submit(record(3), 5);
+    CarveJobHandle alsoLow = scheduler.submit(record(4), 0);
+    EXPECT_EQ(4u, scheduler.getQueuedCount());
+    EXPECT_EQ(1u, scheduler.cancel(dropped.getId()));
+    EXPECT_TRUE(dropped.ready());
+    EXPECT_EQ(CarveJobState::Cancelled, dropped.getState());
+    EXPECT_EQ(0u, dropped.get().getWidth());
+
+    gate.set_value();
+    for (CarveJobHandle* handle : {&blocker, &low, &high, &alsoLow}) handle->get();
+    EXPECT_EQ((std::vector<int>{3, 1, 4}), ran);
+    EXPECT_EQ(CarveJobState::Done, low.getState());
+}
+
+// consecutive passes report one rising range instead of restarting at 0%
+TEST(CarveJobSchedulerTest, ProgressSlices) {
+    std::vector<unsigned int> percents;
+    SeamCarver::ProgressCallback progress = [&](unsigned int done, unsigned int total) {
+        percents.push_back(done * 100 / total);
+        return true;
+    };
+    progressSlice(progress, 0, 2)(5, 10);
+    progressSlice(progress, 0, 2)(10, 10);
+    progressSlice(progress, 1, 2)(0, 4);
+    progressSlice(progress, 1, 2)(4, 4);
+    EXPECT_EQ((std::vector<unsigned int>{25, 50, 50, 100}), percents);
+    EXPECT_FALSE(progressSlice(nullptr, 0, 2));
+}
+
+TEST(CarveJobSchedulerTest, SupersedeAndCarve) {
+    CarveJobScheduler scheduler(2);
+    const uint64_t preview = 7;
+
+    // a job that only ends when cancelled, superseded by a newer one of its group
+    CarveJobHandle stale = scheduler.submit([](const CarveJobContext& context) {
+        while (context.progress()(0, 1)) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        return ImageData();
+    }, 0, preview);
+    while (stale.getState() != CarveJobState::Running) std::this_thread::yield();
+
+    ImageData source = randomImage(48, 20, 3, 21);
+    CarveJob job;
+    job.source = source;
+    job.targetWidth = 40;
+    job.targetHeight = 16;
+    CarveJobHandle current = scheduler.submit(job, 0, preview);
+    // other groups are left alone
+    job.targetWidth = 60;
+    job.targetHeight = 0;
+    CarveJobHandle wider = scheduler.submit(job, 0, 8);
+
+    EXPECT_EQ(0u, stale.get().getWidth());
+    EXPECT_EQ(CarveJobState::Cancelled, stale.getState());
+    const ImageData carved = current.get();
+    EXPECT_EQ(CarveJobState::Done, current.getState());
+    EXPECT_EQ(100u, current.getProgress());
+    EXPECT_EQ(SeamCarver::retarget(source, 40, 16).pixels, carved.pixels);
+    EXPECT_EQ(SeamCarver::insertSeams(source, 60).pixels, wider.get().pixels);
+
+    // invalid targets fail like the rest of the carving API
+    job.targetWidth = 100;
+    EXPECT_EQ(0u, scheduler.submit(job).get().getWidth());
+}
+
+// the consumer only ever sees complete values, in publication order, ending with the last one
+TEST(TripleBufferTest, LatestValueHandoff) {
+    TripleBuffer<std::vector<unsigned int>> buffer;
+    EXPECT_FALSE(buffer.update());
+    EXPECT_TRUE(buffer.readBuffer().empty());
+
+    const unsigned int count = 20000;
+    std::thread producer([&]() {
+        for (unsigned int i = 1; i <= count; ++i) {
+            std::vector<unsigned int>& slot = buffer.writeBuffer();
+            slot.assign(64, i); // reuses the slot's storage
+            buffer.publish();
+        }
+    });
+    unsigned int last = 0;
+    while (last != count) {
+        if (!buffer.update()) continue;
+        const std::vector<unsigned int>& value = buffer.readBuffer();
+        ASSERT_EQ(64u, value.size());
+        ASSERT_GT(value.front(), last);
+        EXPECT_EQ(value.front(), value.back());
+        last = value.front();
+    }
+    producer.join();
+    EXPECT_FALSE(buffer.update());
+}